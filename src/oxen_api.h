@@ -23,6 +23,7 @@
 #include <stdint.h>
 
 int monero_apdu_reset(void);
+int oxen_apdu_hello(void);
 int monero_apdu_lock(void);
 void monero_lock_and_throw(int sw);
 
@@ -30,11 +31,13 @@ void oxen_install(unsigned char netId);
 void monero_init(void);
 void monero_init_private_key(void);
 void monero_wipe_private_key(void);
+void oxen_forget_keys(void);
 
 void monero_init_ux(void);
 int monero_dispatch(void);
 void clear_protocol(void);
 
+unsigned char oxen_nettype(void);
 int monero_apdu_get_network(void);
 int monero_apdu_reset_network(void);  // Only allowed in a debug build
 int monero_apdu_put_key(void);
@@ -63,26 +66,39 @@ int monero_apdu_get_subaddress_spend_public_key(void);
 int monero_apdu_get_subaddress_secret_key(void);
 
 int monero_apdu_get_tx_proof(void);
+int oxen_apdu_get_tx_proof_batch(void);
+int oxen_apdu_reserve_proof(void);
+int oxen_apdu_sign_message(void);
 
 int monero_apdu_open_tx(void);
 int monero_apdu_open_tx_cont(void);
 void monero_reset_tx(int reset_tx_cnt);
 int monero_apdu_open_subtx(void);
+int oxen_session_confirmed(void);
+int oxen_session_allows_output(const unsigned char *Aout,
+                               const unsigned char *Bout,
+                               uint64_t amount);
 int monero_apdu_set_signature_mode(void);
 int monero_apdu_encrypt_payment_id(void);
 int monero_apdu_blind(void);
+int oxen_apdu_blind_batch(void);
 int monero_apdu_unblind(void);
 int monero_apdu_gen_commitment_mask(void);
 
 int monero_apdu_clsag_prehash_init(void);
 int monero_apdu_clsag_prehash_update(void);
 int monero_apdu_clsag_prehash_finalize(void);
+void oxen_prehash_prompt_answered(unsigned int accepted);
 
 int monero_apdu_clsag_prepare(void);
 int monero_apdu_clsag_hash(void);
 int monero_apdu_clsag_hash_set(void);
 int monero_apdu_clsag_sign(void);
+int oxen_apdu_clsag_prepare_slot(void);
+int oxen_apdu_clsag_sign_slots(void);
+void oxen_clsag_reset_slots(void);
 
+int oxen_apdu_get_additional_keys(void);
 int monero_apu_generate_txout_keys(void);
 
 int monero_apdu_prefix_hash_init(void);
@@ -90,6 +106,18 @@ int monero_apdu_prefix_hash_update(void);
 
 int monero_apdu_close_tx(void);
 
+int oxen_apdu_set_policy(void);
+void oxen_policy_confirmed(void);
+int oxen_policy_covers(unsigned char txtype);
+int oxen_policy_allows_fee(uint64_t fee);
+int oxen_policy_allows_output(const unsigned char *Aout,
+                              const unsigned char *Bout,
+                              uint64_t amount);
+void oxen_policy_charge_tx(void);
+void oxen_policy_dest_hash(unsigned char *hash,
+                           const unsigned char *Aout,
+                           const unsigned char *Bout);
+
 void ui_menu_lock_display(void);
 void ui_menu_main_display(void);
 void ui_menu_info_display(void);
@@ -121,6 +149,8 @@ uint64_t monero_bamount2uint64(unsigned char *binary);
 /** uint64 atomic currency amount to human-readable currency amount string. `str` must be at least
  * 22 chars long. */
 void oxen_currency_str(uint64_t atomic_oxen, char *str);
+unsigned int oxen_be_divmod(unsigned char *num, unsigned int len, unsigned int divisor);
+void oxen_uint64_to_be(uint64_t v, unsigned char *num);
 
 int monero_abort_tx(void);
 int monero_unblind(unsigned char *v,
@@ -130,11 +160,20 @@ int monero_unblind(unsigned char *v,
 void ui_menu_validation_display(void);
 void ui_menu_stake_validation_display(void);
 void ui_menu_unlock_validation_display(void);
+void ui_menu_unlock_batch_validation_display(void);
 void ui_menu_lns_validation_display(void);
+void ui_menu_lns_batch_validation_display(void);
+void ui_menu_reserve_proof_validation_display(void);
+void ui_menu_sign_message_validation_display(void);
 void ui_menu_fee_validation_display(void);
 void ui_menu_lns_fee_validation_display(void);
 void ui_menu_change_validation_display(void);
 void ui_menu_timelock_validation_display(void);
+void ui_menu_summary_validation_display(void);
+void ui_menu_policy_caps_display(void);
+void ui_menu_policy_dest_display(void);
+void ui_menu_subaddr_table_display(void);
+void ui_menu_session_display(void);
 
 void ui_menu_opentx_display(unsigned char final_step);
 /* ----------------------------------------------------------------------- */
@@ -158,6 +197,7 @@ void monero_generate_keypair(unsigned char *ec_pub, unsigned char *ec_priv);
  * P [in]  point in 02 y or 04 x y format
  * k [in]  32 bytes scalar
  */
+void oxen_drv_cache_wipe(void);
 void monero_generate_key_derivation(unsigned char *drv_data,
                                     const unsigned char *P,
                                     const unsigned char *scalar);
@@ -203,9 +243,35 @@ void monero_derive_subaddress_public_key(unsigned char *x,
                                          unsigned int index);
 void monero_get_subaddress_spend_public_key(unsigned char *x, const unsigned char *index);
 void monero_get_subaddress(unsigned char *C, unsigned char *D, const unsigned char *index);
+int oxen_subaddr_table_get(unsigned char *C, unsigned char *D, const unsigned char *index);
+int oxen_subaddr_table_find(const unsigned char *C, const unsigned char *D);
+int oxen_apdu_subaddr_table(void);
+void oxen_subaddr_table_confirmed(void);
 void monero_get_subaddress_secret_key(unsigned char *sub_s,
                                       const unsigned char *s,
                                       const unsigned char *index);
+void oxen_subaddr_key_load(const unsigned char *index);
+void oxen_subaddr_key_wipe(void);
+
+/* ----------------------------------------------------------------------- */
+/* ---                              SCRATCH                           ---- */
+/* ----------------------------------------------------------------------- */
+void oxen_scratch_reset(void);
+unsigned int oxen_scratch_mark(void);
+unsigned char *oxen_scratch_alloc(unsigned int len);
+void oxen_scratch_release(unsigned int mark);
+
+/* ----------------------------------------------------------------------- */
+/* ---                            TRANSCRIPT                          ---- */
+/* ----------------------------------------------------------------------- */
+void oxen_transcript_reset(void);
+void oxen_transcript_absorb(unsigned int lane, const unsigned char *record, unsigned int len);
+void oxen_transcript_absorb_output(const unsigned char *A,
+                                   const unsigned char *B,
+                                   unsigned char is_change,
+                                   const unsigned char *amount_key);
+void oxen_transcript_snapshot(unsigned int lane);
+void oxen_transcript_check(unsigned int lane, int sw);
 
 /* ----------------------------------------------------------------------- */
 /* ---                              CRYPTO                            ---- */
@@ -268,6 +334,11 @@ void monero_derivation_to_scalar(unsigned char *scalar,
  */
 void monero_ecmul_k(unsigned char *W, const unsigned char *P, const unsigned char *scalar32);
 
+/*
+ * W = k.P, with P uncompressed (04 || x || y)
+ */
+void monero_ecmul_k_xy(unsigned char *W, const unsigned char *Pxy, const unsigned char *scalar32);
+
 /*
  * W = 8.P
  */
@@ -57,6 +57,43 @@ int monero_apdu_blind() {
     return SW_OK;
 }
 
+/* ----------------------------------------------------------------------- */
+/* ---                                                                 --- */
+/* ----------------------------------------------------------------------- */
+// Batched [BLIND,1,x]: generates the commitment mask and then blinds the (short) amount of each
+// output, i.e. INS_GEN_COMMITMENT_MASK followed by INS_BLIND, for as many outputs as the host fits
+// in a page; pages are numbered with p2 as for INS_PREFIX_HASH.  Each entry is
+// [enc(AKout) || hmac || amount(8)] and gets back [k || blinded amount(8)].
+int oxen_apdu_blind_batch(void) {
+    unsigned int count, i;
+    unsigned char AKout[32];
+    unsigned char *out;
+
+    if ((G_oxen_state.options & 0x03) != 2) THROW(SW_WRONG_DATA);
+
+    count = monero_io_fetch_available() / 72;
+    if (count == 0 || count * 72 != (unsigned int) monero_io_fetch_available()) {
+        THROW(SW_WRONG_LENGTH);
+    }
+
+    // Each 40-byte result is written over the already consumed part of the (72-byte) entries
+    for (i = 0; i < count; i++) {
+        out = G_oxen_state.io_buffer + 40 * i;
+        monero_io_fetch_decrypt(AKout, 32, TYPE_AMOUNT_KEY);
+        monero_genCommitmentMask(out, AKout);
+        monero_ecdhHash(AKout, AKout);
+        monero_io_fetch(out + 32, 8);
+        for (int j = 0; j < 8; j++) {
+            out[32 + j] ^= AKout[j];
+        }
+    }
+    memset(AKout, 0, 32);
+
+    monero_io_discard(0);
+    monero_io_inserted(40 * count);
+    return SW_OK;
+}
+
 /* ----------------------------------------------------------------------- */
 /* ---                                                                 --- */
 /* ----------------------------------------------------------------------- */
@@ -23,6 +23,35 @@
 #include "oxen_api.h"
 #include "oxen_vars.h"
 
+/* ----------------------------------------------------------------------- */
+/* ---                                                                 --- */
+/* ----------------------------------------------------------------------- */
+// Appends a.G, a.H, I = p.H and D = z.H.  A fake (fee estimation) signature is thrown away by the
+// wallet, so H stands in for all four points there.
+static void oxen_clsag_insert_points(const unsigned char *H,
+                                     const unsigned char *a,
+                                     const unsigned char *p,
+                                     const unsigned char *z) {
+    unsigned char W[32];
+
+    if (OXEN_TX_FAKE_MODE()) {
+        for (int i = 0; i < 4; i++) monero_io_insert(H, 32);
+        return;
+    }
+    // a.G
+    monero_ecmul_G(W, a);
+    monero_io_insert(W, 32);
+    // a.H
+    monero_ecmul_k(W, H, a);
+    monero_io_insert(W, 32);
+    // I = p.H
+    monero_ecmul_k(W, H, p);
+    monero_io_insert(W, 32);
+    // D = z.H
+    monero_ecmul_k(W, H, z);
+    monero_io_insert(W, 32);
+}
+
 /* ----------------------------------------------------------------------- */
 /* ---                                                                 --- */
 /* ----------------------------------------------------------------------- */
@@ -45,7 +74,6 @@ int monero_apdu_clsag_prepare() {
     unsigned char p[32];
     unsigned char z[32];
     unsigned char H[32];
-    unsigned char W[32];
 
     G_oxen_state.tx_sign_cnt++;
     if (G_oxen_state.tx_sign_cnt == 0) {
@@ -60,19 +88,8 @@ int monero_apdu_clsag_prepare() {
     // a
     monero_rng_mod_order(a);
     monero_io_insert_encrypt(a, 32, TYPE_ALPHA);
-    // a.G
-    monero_ecmul_G(W, a);
-    monero_io_insert(W, 32);
-    // a.H
-    monero_ecmul_k(W, H, a);
-    monero_io_insert(W, 32);
-    // I = p.H
-    monero_ecmul_k(W, H, p);
-    monero_io_insert(W, 32);
-
-    // D = z.H
-    monero_ecmul_k(W, H, z);
-    monero_io_insert(W, 32);
+    oxen_clsag_insert_points(H, a, p, z);
+    G_oxen_state.clsag_unsigned = 1;
 
     return SW_OK;
 }
@@ -90,10 +107,16 @@ int monero_apdu_clsag_prepare() {
 int monero_apdu_clsag_hash() {
     unsigned char c[32];
 
-    // We init hash if we just came off [1], or we just finished a [2,0].  In either case we require
-    // the current command be [2,1] or [2,0] (i.e. first of multipart, or single-part):
-    if (G_oxen_state.tx_state_p1 == 1 || OXEN_TX_STATE_P_EQUALS(2, 0)) {
+    // We init hash if we just came off [1] (or [4]), or we just finished a [2,0].  In either case
+    // we require the current command be [2,1] or [2,0] (i.e. first of multipart, or single-part):
+    if (G_oxen_state.tx_state_p1 == 1 || G_oxen_state.tx_state_p1 == 4 ||
+        OXEN_TX_STATE_P_EQUALS(2, 0)) {
         if (G_oxen_state.io_p2 > 1) THROW(SW_SUBCOMMAND_NOT_ALLOWED);
+        // In a batch, each prepared slot gets exactly one hash
+        if (G_oxen_state.clsag_slot_hashed >= G_oxen_state.clsag_slot_cnt &&
+            G_oxen_state.clsag_slot_cnt) {
+            THROW(SW_SUBCOMMAND_NOT_ALLOWED);
+        }
         cx_keccak_init(&G_oxen_state.keccak_alt, 256);
     } else if (!(G_oxen_state.io_p2 == 0 ||  // this chunk is last, *or*:
                  G_oxen_state.io_p2 == (G_oxen_state.tx_state_p2 == 255
@@ -113,7 +136,11 @@ int monero_apdu_clsag_hash() {
         oxen_hash_final(&G_oxen_state.keccak_alt, c);
         monero_reduce(c);
         monero_io_insert(c, 32);
-        memmove(G_oxen_state.clsag_c, c, 32);
+        if (G_oxen_state.clsag_slot_cnt) {
+            memmove(G_oxen_state.clsag_slots[G_oxen_state.clsag_slot_hashed++].c, c, 32);
+        } else {
+            memmove(G_oxen_state.clsag_c, c, 32);
+        }
     }
     return SW_OK;
 }
@@ -138,13 +165,40 @@ bool device_default::clsag_sign(const rct::key &c,
         return true;
     }
 */
+// s = a - c*(mu_C*z + mu_P*p).  All arguments must be reduced; mu_P is clobbered.
+static void oxen_clsag_sign_s(unsigned char *s,
+                              const unsigned char *a,
+                              const unsigned char *p,
+                              const unsigned char *z,
+                              unsigned char *mu_P,
+                              const unsigned char *mu_C,
+                              const unsigned char *c) {
+    // s0_p_mu_P = mu_P*p
+    // s0_add_z_mu_C = mu_C*z + s0_p_mu_P
+    //
+    // s = a - c*s0_add_z_mu_C
+    //   = a - c*(mu_C*z + mu_P*p)
+
+    // s = p*mu_P
+    monero_multm(s, p, mu_P);
+    // mu_P = mu_C*z
+    monero_multm(mu_P, mu_C, z);
+    // s = p*mu_P + mu_C*z
+    monero_addm(s, s, mu_P);
+    // mu_P = c * (p*mu_P + mu_C*z)
+    monero_multm(mu_P, c, s);
+    // s = a - c*(p*mu_P + mu_C*z)
+    monero_subm(s, a, mu_P);
+}
+
 int monero_apdu_clsag_sign() {
     unsigned char s[32];
-    unsigned char *a = &G_oxen_state.tmp[0];
-    unsigned char *p = &G_oxen_state.tmp[32];
-    unsigned char *z = &G_oxen_state.tmp[64];
-    unsigned char *mu_P = &G_oxen_state.tmp[96];
-    unsigned char *mu_C = &G_oxen_state.tmp[128];
+    unsigned int mark = oxen_scratch_mark();
+    unsigned char *a = oxen_scratch_alloc(32);
+    unsigned char *p = oxen_scratch_alloc(32);
+    unsigned char *z = oxen_scratch_alloc(32);
+    unsigned char *mu_P = oxen_scratch_alloc(32);
+    unsigned char *mu_C = oxen_scratch_alloc(32);
 
     if (G_oxen_state.tx_sig_mode == TRANSACTION_CREATE_FAKE) {
         monero_io_fetch(a, 32);
@@ -172,24 +226,122 @@ int monero_apdu_clsag_sign() {
     monero_reduce(mu_C);
     monero_reduce(G_oxen_state.clsag_c);
 
-    // s0_p_mu_P = mu_P*p
-    // s0_add_z_mu_C = mu_C*z + s0_p_mu_P
-    //
-    // s = a - c*s0_add_z_mu_C
-    //   = a - c*(mu_C*z + mu_P*p)
-
-    // s = p*mu_P
-    monero_multm(s, p, mu_P);
-    // mu_P = mu_C*z
-    monero_multm(mu_P, mu_C, z);
-    // s = p*mu_P + mu_C*z
-    monero_addm(s, s, mu_P);
-    // mu_P = c * (p*mu_P + mu_C*z)
-    monero_multm(mu_P, G_oxen_state.clsag_c, s);
-    // s = a - c*(p*mu_P + mu_C*z)
-    monero_subm(s, a, mu_P);
+    oxen_clsag_sign_s(s, a, p, z, mu_P, mu_C, G_oxen_state.clsag_c);
+    oxen_scratch_release(mark);
+    G_oxen_state.clsag_unsigned = 0;
 
     monero_io_insert(s, 32);
 
     return SW_OK;
 }
+
+/* ----------------------------------------------------------------------- */
+/* ---                           CLSAG batch                           --- */
+/* ----------------------------------------------------------------------- */
+/*
+ * Several inputs can be signed as a batch: one [CLSAG,4,0] per input (same data as [1,0], but p and
+ * z stay in a slot and a is derived from a per-batch seed, so nothing but aG, aH, I and D is
+ * returned), then one [CLSAG,2,x] hash sequence per input, in the same order, and finally
+ * [CLSAG,5,x] pages of [mu_P || mu_C] entries returning the s of each input in turn.
+ */
+void oxen_clsag_reset_slots(void) {
+    memset(G_oxen_state.clsag_seed, 0, 32);
+    memset(G_oxen_state.clsag_slots, 0, sizeof(G_oxen_state.clsag_slots));
+    G_oxen_state.clsag_slot_cnt = 0;
+    G_oxen_state.clsag_slot_hashed = 0;
+    G_oxen_state.clsag_slot_signed = 0;
+    G_oxen_state.clsag_unsigned = 0;
+}
+
+static void oxen_clsag_slot_alpha(unsigned char *a, unsigned int slot) {
+    monero_derivation_to_scalar(a, G_oxen_state.clsag_seed, slot);
+    monero_check_scalar_not_null(a);
+}
+
+int oxen_apdu_clsag_prepare_slot(void) {
+    unsigned char a[32];
+    unsigned char H[32];
+    oxen_clsag_slot_t *slot;
+
+    if (G_oxen_state.clsag_slot_cnt >= CLSAG_MAX_SLOTS) THROW(SW_WRONG_DATA_RANGE);
+
+    G_oxen_state.tx_sign_cnt++;
+    if (G_oxen_state.tx_sign_cnt == 0) {
+        monero_lock_and_throw(SW_SECURITY_MAX_SIGNATURE_REACHED);
+    }
+
+    // New batch: fresh seed for its alphas
+    if (G_oxen_state.clsag_slot_cnt == 0) {
+        cx_rng(G_oxen_state.clsag_seed, 32);
+    }
+    slot = &G_oxen_state.clsag_slots[G_oxen_state.clsag_slot_cnt];
+
+    monero_io_fetch_decrypt(slot->p, 32, TYPE_SCALAR);
+    monero_io_fetch(slot->z, 32);
+    monero_io_fetch(H, 32);
+    monero_io_discard(1);
+
+    oxen_clsag_slot_alpha(a, G_oxen_state.clsag_slot_cnt);
+    G_oxen_state.clsag_slot_cnt++;
+
+    oxen_clsag_insert_points(H, a, slot->p, slot->z);
+
+    memset(a, 0, 32);
+    return SW_OK;
+}
+
+int oxen_apdu_clsag_sign_slots(void) {
+    unsigned int count, i;
+    unsigned char a[32];
+    unsigned char mu_P[32];
+    unsigned char mu_C[32];
+    oxen_clsag_slot_t *slot;
+
+    count = monero_io_fetch_available() / 64;
+    if (count == 0 || count * 64 != (unsigned int) monero_io_fetch_available() ||
+        G_oxen_state.clsag_slot_signed + count > G_oxen_state.clsag_slot_cnt) {
+        THROW(SW_WRONG_LENGTH);
+    }
+    // The last page must complete the batch
+    if (G_oxen_state.io_p2 == 0 &&
+        G_oxen_state.clsag_slot_signed + count != G_oxen_state.clsag_slot_cnt) {
+        THROW(SW_WRONG_DATA);
+    }
+
+    // Each 32-byte s is written over the already consumed part of the (64-byte) entries
+    for (i = 0; i < count; i++) {
+        monero_io_fetch(mu_P, 32);
+        monero_io_fetch(mu_C, 32);
+
+        slot = &G_oxen_state.clsag_slots[G_oxen_state.clsag_slot_signed];
+        oxen_clsag_slot_alpha(a, G_oxen_state.clsag_slot_signed);
+        G_oxen_state.clsag_slot_signed++;
+
+        monero_check_scalar_not_null(slot->p);
+        monero_check_scalar_not_null(slot->z);
+
+        monero_reduce(slot->p);
+        monero_reduce(slot->z);
+        monero_reduce(slot->c);
+        monero_reduce(mu_P);
+        monero_reduce(mu_C);
+
+        oxen_clsag_sign_s(G_oxen_state.io_buffer + 32 * i,
+                          a,
+                          slot->p,
+                          slot->z,
+                          mu_P,
+                          mu_C,
+                          slot->c);
+        memset(slot, 0, sizeof(*slot));
+    }
+    memset(a, 0, 32);
+
+    if (G_oxen_state.io_p2 == 0) {
+        oxen_clsag_reset_slots();
+    }
+
+    monero_io_discard(0);
+    monero_io_inserted(32 * count);
+    return SW_OK;
+}
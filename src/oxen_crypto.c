@@ -333,18 +333,18 @@ const unsigned char C_fe_qm5div8[] = {
 void monero_ge_fromfe_frombytes(unsigned char *ge, const unsigned char *bytes) {
 #define MOD              (unsigned char *) C_ED25519_FIELD, 32
 #define fe_isnegative(f) (f[31] & 1)
-#define u                (G_oxen_state.io_buffer + 0 * 32)
-#define v                (G_oxen_state.io_buffer + 1 * 32)
-#define w                (G_oxen_state.io_buffer + 2 * 32)
-#define x                (G_oxen_state.io_buffer + 3 * 32)
-#define y                (G_oxen_state.io_buffer + 4 * 32)
-#define z                (G_oxen_state.io_buffer + 5 * 32)
-#define rX               (G_oxen_state.io_buffer + 6 * 32)
-#define rY               (G_oxen_state.io_buffer + 7 * 32)
-#define rZ               (G_oxen_state.io_buffer + 8 * 32)
-
-#if MONERO_IO_BUFFER_LENGTH < (9 * 32)
-#error MONERO_IO_BUFFER_LENGTH is too small
+#define u                (reg + 0 * 32)
+#define v                (reg + 1 * 32)
+#define w                (reg + 2 * 32)
+#define x                (reg + 3 * 32)
+#define y                (reg + 4 * 32)
+#define z                (reg + 5 * 32)
+#define rX               (reg + 6 * 32)
+#define rY               (reg + 7 * 32)
+#define rZ               (reg + 8 * 32)
+
+#if SCRATCH_SIZE < (9 * 32)
+#error SCRATCH_SIZE is too small
 #endif
 
     union {
@@ -362,6 +362,8 @@ void monero_ge_fromfe_frombytes(unsigned char *ge, const unsigned char *bytes) {
 #define Pxy uv._Pxy
 
     unsigned char sign;
+    unsigned int mark = oxen_scratch_mark();
+    unsigned char *reg = oxen_scratch_alloc(9 * 32);
 
     // cx works in BE
     monero_reverse32(u, bytes);
@@ -441,6 +443,7 @@ setsign:
     cx_math_multm(&Pxy[1 + 32], rY, u, MOD);
     cx_edwards_compress_point(CX_CURVE_Ed25519, Pxy, sizeof(Pxy));
     memmove(ge, &Pxy[1], 32);
+    oxen_scratch_release(mark);
 
 #undef u
 #undef v
@@ -475,10 +478,48 @@ void monero_hash_to_scalar(unsigned char *scalar,
 /* ----------------------------------------------------------------------- */
 /* ---                                                                 --- */
 /* ----------------------------------------------------------------------- */
+// H_p(P) as an uncompressed point (04 || x || y).  Key images and their signatures usually come
+// in pairs for the same P, so the last few results are kept (without the point decompression).
+static void oxen_hash_to_ec_xy(unsigned char *Hxy, const unsigned char *P) {
+    unsigned int i;
+
+    for (i = 0; i < G_oxen_state.hp_cache_cnt; i++) {
+        if (memcmp(G_oxen_state.hp_cache[i].P, P, 32) == 0) {
+            // move to the front, through Hxy rather than a copy of the entry on the stack
+            memmove(Hxy, G_oxen_state.hp_cache[i].Hxy, 65);
+            memmove(&G_oxen_state.hp_cache[1],
+                    &G_oxen_state.hp_cache[0],
+                    i * sizeof(oxen_hp_cache_t));
+            memmove(G_oxen_state.hp_cache[0].P, P, 32);
+            memmove(G_oxen_state.hp_cache[0].Hxy, Hxy, 65);
+            return;
+        }
+    }
+
+    oxen_keccak_256(&G_oxen_state.keccak, P, 32, &Hxy[1]);
+    monero_ge_fromfe_frombytes(&Hxy[1], &Hxy[1]);
+    Hxy[0] = 0x02;
+    cx_edwards_decompress_point(CX_CURVE_Ed25519, Hxy, 65);
+    // x8
+    cx_ecfp_add_point(CX_CURVE_Ed25519, Hxy, Hxy, Hxy, 65);
+    cx_ecfp_add_point(CX_CURVE_Ed25519, Hxy, Hxy, Hxy, 65);
+    cx_ecfp_add_point(CX_CURVE_Ed25519, Hxy, Hxy, Hxy, 65);
+
+    // evict the least recently used
+    memmove(&G_oxen_state.hp_cache[1],
+            &G_oxen_state.hp_cache[0],
+            (HP_CACHE_SIZE - 1) * sizeof(oxen_hp_cache_t));
+    memmove(G_oxen_state.hp_cache[0].P, P, 32);
+    memmove(G_oxen_state.hp_cache[0].Hxy, Hxy, 65);
+    if (G_oxen_state.hp_cache_cnt < HP_CACHE_SIZE) G_oxen_state.hp_cache_cnt++;
+}
+
 void monero_hash_to_ec(unsigned char *ec, const unsigned char *ec_pub) {
-    oxen_keccak_256(&G_oxen_state.keccak, ec_pub, 32, ec);
-    monero_ge_fromfe_frombytes(ec, ec);
-    monero_ecmul_8(ec, ec);
+    unsigned char Hxy[65];
+
+    oxen_hash_to_ec_xy(Hxy, ec_pub);
+    cx_edwards_compress_point(CX_CURVE_Ed25519, Hxy, sizeof(Hxy));
+    memmove(ec, &Hxy[1], 32);
 }
 
 /* ----------------------------------------------------------------------- */
@@ -492,14 +533,51 @@ void monero_generate_keypair(unsigned char *ec_pub, unsigned char *ec_priv) {
 /* ----------------------------------------------------------------------- */
 /* ---                                                                 --- */
 /* ----------------------------------------------------------------------- */
+/*
+ * A tx derives the same (P, scalar) pair over and over (outputs to the same recipient, payment id
+ * encryption, host GEN_KEY_DERIVATION calls), so the last few derivations are kept.  They are
+ * looked up by an HMAC under the per-tx hmac_key, so that the tags say nothing about the scalars,
+ * and wiped with it.
+ */
+void oxen_drv_cache_wipe(void) {
+    memset(G_oxen_state.drv_cache, 0, sizeof(G_oxen_state.drv_cache));
+    G_oxen_state.drv_cache_cnt = 0;
+    G_oxen_state.drv_cache_next = 0;
+}
+
 void monero_generate_key_derivation(unsigned char *drv_data,
                                     const unsigned char *P,
                                     const unsigned char *scalar) {
     unsigned char s[32];
+    unsigned char tag[64];
+    oxen_drv_cache_t *entry;
+
+    memmove(tag, P, 32);
+    memmove(tag + 32, scalar, 32);
+    cx_hmac_sha256(G_oxen_state.hmac_key, 32, tag, 64, tag, 32);
+    for (unsigned int i = 0; i < G_oxen_state.drv_cache_cnt; i++) {
+        if (memcmp(G_oxen_state.drv_cache[i].tag, tag, 16) == 0) {
+#if DEBUG_HWDEVICE
+            G_oxen_state.drv_cache_hits++;
+#endif
+            memmove(drv_data, G_oxen_state.drv_cache[i].drv, 32);
+            return;
+        }
+    }
+#if DEBUG_HWDEVICE
+    G_oxen_state.drv_cache_misses++;
+#endif
+
     monero_reverse32(s, scalar);
     cx_math_multm(s, s, C_EIGHT, (unsigned char *) C_ED25519_ORDER, 32);
     monero_reverse32(s, s);
     monero_ecmul_k(drv_data, P, s);
+
+    entry = &G_oxen_state.drv_cache[G_oxen_state.drv_cache_next];
+    memmove(entry->tag, tag, 16);
+    memmove(entry->drv, drv_data, 32);
+    G_oxen_state.drv_cache_next = (G_oxen_state.drv_cache_next + 1) % DRV_CACHE_SIZE;
+    if (G_oxen_state.drv_cache_cnt < DRV_CACHE_SIZE) G_oxen_state.drv_cache_cnt++;
 }
 
 /* ----------------------------------------------------------------------- */
@@ -556,8 +634,10 @@ void monero_secret_key_to_public_key(unsigned char *ec_pub, const unsigned char
 /* ---                                                                 --- */
 /* ----------------------------------------------------------------------- */
 void monero_generate_key_image(unsigned char *img, const unsigned char *P, const unsigned char *x) {
-    monero_hash_to_ec(img, P);
-    monero_ecmul_k(img, img, x);
+    unsigned char Hxy[65];
+
+    oxen_hash_to_ec_xy(Hxy, P);
+    monero_ecmul_k_xy(img, Hxy, x);
 }
 
 /* ----------------------------------------------------------------------- */
@@ -569,6 +649,7 @@ void oxen_generate_key_image_signature(unsigned char *sig,
                                        const unsigned char *x) {
     unsigned char k[32];
     unsigned char tmp[32];
+    unsigned char Hxy[65];
 
     cx_keccak_init(&G_oxen_state.keccak_alt, 256);        // Need to calculate H(I || L || R)
     oxen_hash_update(&G_oxen_state.keccak_alt, img, 32);  // H(I ||...
@@ -577,8 +658,8 @@ void oxen_generate_key_image_signature(unsigned char *sig,
     monero_ecmul_G(tmp, k);                               // L0 = kG
     oxen_hash_update(&G_oxen_state.keccak_alt, tmp, 32);  // H(...|| L ||...)
 
-    monero_hash_to_ec(tmp, P);                            // H(P)
-    monero_ecmul_k(tmp, tmp, k);                          // R = kH(P)
+    oxen_hash_to_ec_xy(Hxy, P);                           // H(P)
+    monero_ecmul_k_xy(tmp, Hxy, k);                       // R = kH(P)
     oxen_hash_update(&G_oxen_state.keccak_alt, tmp, 32);  // H(...|| R)
 
     // sig = [c,r]
@@ -638,6 +719,7 @@ void monero_derive_subaddress_public_key(unsigned char *x,
 /* ---                                                                 --- */
 /* ----------------------------------------------------------------------- */
 void monero_get_subaddress_spend_public_key(unsigned char *x, const unsigned char *index) {
+    if (oxen_subaddr_table_get(NULL, x, index)) return;
     // m = Hs(a || index_major || index_minor)
     monero_get_subaddress_secret_key(x, G_oxen_state.view_priv, index);
     // M = m*G
@@ -650,6 +732,7 @@ void monero_get_subaddress_spend_public_key(unsigned char *x, const unsigned cha
 /* ---                                                                 --- */
 /* ----------------------------------------------------------------------- */
 void monero_get_subaddress(unsigned char *C, unsigned char *D, const unsigned char *index) {
+    if (oxen_subaddr_table_get(C, D, index)) return;
     // retrieve D
     monero_get_subaddress_spend_public_key(D, index);
     // C = a*D
@@ -700,110 +783,140 @@ void monero_check_scalar_not_null(const unsigned char *s) {
 /* ---                                                                 --- */
 /* ----------------------------------------------------------------------- */
 void monero_ecmul_G(unsigned char *W, const unsigned char *scalar32) {
-    unsigned char Pxy[65];
     unsigned char s[32];
+    unsigned int mark = oxen_scratch_mark();
+    unsigned char *Pxy = oxen_scratch_alloc(65);
+
     monero_reverse32(s, scalar32);
     memmove(Pxy, C_ED25519_G, 65);
-    cx_ecfp_scalar_mult(CX_CURVE_Ed25519, Pxy, sizeof(Pxy), s, 32);
-    cx_edwards_compress_point(CX_CURVE_Ed25519, Pxy, sizeof(Pxy));
+    cx_ecfp_scalar_mult(CX_CURVE_Ed25519, Pxy, 65, s, 32);
+    cx_edwards_compress_point(CX_CURVE_Ed25519, Pxy, 65);
     memmove(W, &Pxy[1], 32);
+    oxen_scratch_release(mark);
 }
 
 /* ----------------------------------------------------------------------- */
 /* ---                                                                 --- */
 /* ----------------------------------------------------------------------- */
 void monero_ecmul_H(unsigned char *W, const unsigned char *scalar32) {
-    unsigned char Pxy[65];
     unsigned char s[32];
+    unsigned int mark = oxen_scratch_mark();
+    unsigned char *Pxy = oxen_scratch_alloc(65);
 
     monero_reverse32(s, scalar32);
 
     Pxy[0] = 0x02;
     memmove(&Pxy[1], C_ED25519_Hy, 32);
-    cx_edwards_decompress_point(CX_CURVE_Ed25519, Pxy, sizeof(Pxy));
+    cx_edwards_decompress_point(CX_CURVE_Ed25519, Pxy, 65);
 
-    cx_ecfp_scalar_mult(CX_CURVE_Ed25519, Pxy, sizeof(Pxy), s, 32);
-    cx_edwards_compress_point(CX_CURVE_Ed25519, Pxy, sizeof(Pxy));
+    cx_ecfp_scalar_mult(CX_CURVE_Ed25519, Pxy, 65, s, 32);
+    cx_edwards_compress_point(CX_CURVE_Ed25519, Pxy, 65);
 
     memmove(W, &Pxy[1], 32);
+    oxen_scratch_release(mark);
 }
 
 /* ----------------------------------------------------------------------- */
 /* ---                                                                 --- */
 /* ----------------------------------------------------------------------- */
 void monero_ecmul_k(unsigned char *W, const unsigned char *P, const unsigned char *scalar32) {
-    unsigned char Pxy[65];
     unsigned char s[32];
+    unsigned int mark = oxen_scratch_mark();
+    unsigned char *Pxy = oxen_scratch_alloc(65);
 
     monero_reverse32(s, scalar32);
 
     Pxy[0] = 0x02;
     memmove(&Pxy[1], P, 32);
-    cx_edwards_decompress_point(CX_CURVE_Ed25519, Pxy, sizeof(Pxy));
+    cx_edwards_decompress_point(CX_CURVE_Ed25519, Pxy, 65);
 
-    cx_ecfp_scalar_mult(CX_CURVE_Ed25519, Pxy, sizeof(Pxy), s, 32);
-    cx_edwards_compress_point(CX_CURVE_Ed25519, Pxy, sizeof(Pxy));
+    cx_ecfp_scalar_mult(CX_CURVE_Ed25519, Pxy, 65, s, 32);
+    cx_edwards_compress_point(CX_CURVE_Ed25519, Pxy, 65);
 
     memmove(W, &Pxy[1], 32);
+    oxen_scratch_release(mark);
+}
+
+/* ----------------------------------------------------------------------- */
+/* ---                                                                 --- */
+/* ----------------------------------------------------------------------- */
+// Same as monero_ecmul_k, for a point that is already uncompressed (04 || x || y)
+void monero_ecmul_k_xy(unsigned char *W, const unsigned char *Pxy, const unsigned char *scalar32) {
+    unsigned char s[32];
+    unsigned int mark = oxen_scratch_mark();
+    unsigned char *Wxy = oxen_scratch_alloc(65);
+
+    monero_reverse32(s, scalar32);
+    memmove(Wxy, Pxy, 65);
+    cx_ecfp_scalar_mult(CX_CURVE_Ed25519, Wxy, 65, s, 32);
+    cx_edwards_compress_point(CX_CURVE_Ed25519, Wxy, 65);
+    memmove(W, &Wxy[1], 32);
+    oxen_scratch_release(mark);
 }
 
 /* ----------------------------------------------------------------------- */
 /* ---                                                                 --- */
 /* ----------------------------------------------------------------------- */
 void monero_ecmul_8(unsigned char *W, const unsigned char *P) {
-    unsigned char Pxy[65];
+    unsigned int mark = oxen_scratch_mark();
+    unsigned char *Pxy = oxen_scratch_alloc(65);
 
     Pxy[0] = 0x02;
     memmove(&Pxy[1], P, 32);
-    cx_edwards_decompress_point(CX_CURVE_Ed25519, Pxy, sizeof(Pxy));
-    cx_ecfp_add_point(CX_CURVE_Ed25519, Pxy, Pxy, Pxy, sizeof(Pxy));
-    cx_ecfp_add_point(CX_CURVE_Ed25519, Pxy, Pxy, Pxy, sizeof(Pxy));
-    cx_ecfp_add_point(CX_CURVE_Ed25519, Pxy, Pxy, Pxy, sizeof(Pxy));
-    cx_edwards_compress_point(CX_CURVE_Ed25519, Pxy, sizeof(Pxy));
+    cx_edwards_decompress_point(CX_CURVE_Ed25519, Pxy, 65);
+    cx_ecfp_add_point(CX_CURVE_Ed25519, Pxy, Pxy, Pxy, 65);
+    cx_ecfp_add_point(CX_CURVE_Ed25519, Pxy, Pxy, Pxy, 65);
+    cx_ecfp_add_point(CX_CURVE_Ed25519, Pxy, Pxy, Pxy, 65);
+    cx_edwards_compress_point(CX_CURVE_Ed25519, Pxy, 65);
     memmove(W, &Pxy[1], 32);
+    oxen_scratch_release(mark);
 }
 
 /* ----------------------------------------------------------------------- */
 /* ---                                                                 --- */
 /* ----------------------------------------------------------------------- */
 void monero_ecadd(unsigned char *W, const unsigned char *P, const unsigned char *Q) {
-    unsigned char Pxy[65];
-    unsigned char Qxy[65];
+    unsigned int mark = oxen_scratch_mark();
+    unsigned char *Pxy = oxen_scratch_alloc(65);
+    unsigned char *Qxy = oxen_scratch_alloc(65);
 
     Pxy[0] = 0x02;
     memmove(&Pxy[1], P, 32);
-    cx_edwards_decompress_point(CX_CURVE_Ed25519, Pxy, sizeof(Pxy));
+    cx_edwards_decompress_point(CX_CURVE_Ed25519, Pxy, 65);
 
     Qxy[0] = 0x02;
     memmove(&Qxy[1], Q, 32);
-    cx_edwards_decompress_point(CX_CURVE_Ed25519, Qxy, sizeof(Qxy));
+    cx_edwards_decompress_point(CX_CURVE_Ed25519, Qxy, 65);
 
-    cx_ecfp_add_point(CX_CURVE_Ed25519, Pxy, Pxy, Qxy, sizeof(Pxy));
+    cx_ecfp_add_point(CX_CURVE_Ed25519, Pxy, Pxy, Qxy, 65);
 
-    cx_edwards_compress_point(CX_CURVE_Ed25519, Pxy, sizeof(Pxy));
+    cx_edwards_compress_point(CX_CURVE_Ed25519, Pxy, 65);
     memmove(W, &Pxy[1], 32);
+    oxen_scratch_release(mark);
 }
 
 /* ----------------------------------------------------------------------- */
 /* ---                                                                 --- */
 /* ----------------------------------------------------------------------- */
 void monero_ecsub(unsigned char *W, const unsigned char *P, const unsigned char *Q) {
-    unsigned char Pxy[65];
-    unsigned char Qxy[65];
+    unsigned int mark = oxen_scratch_mark();
+    unsigned char *Pxy = oxen_scratch_alloc(65);
+    unsigned char *Qxy = oxen_scratch_alloc(65);
 
     Pxy[0] = 0x02;
     memmove(&Pxy[1], P, 32);
-    cx_edwards_decompress_point(CX_CURVE_Ed25519, Pxy, sizeof(Pxy));
+    cx_edwards_decompress_point(CX_CURVE_Ed25519, Pxy, 65);
 
     Qxy[0] = 0x02;
     memmove(&Qxy[1], Q, 32);
-    cx_edwards_decompress_point(CX_CURVE_Ed25519, Qxy, sizeof(Qxy));
+    cx_edwards_decompress_point(CX_CURVE_Ed25519, Qxy, 65);
 
     cx_math_sub(Qxy + 1, (unsigned char *) C_ED25519_FIELD, Qxy + 1, 32);
-    cx_ecfp_add_point(CX_CURVE_Ed25519, Pxy, Pxy, Qxy, sizeof(Pxy));
+    cx_ecfp_add_point(CX_CURVE_Ed25519, Pxy, Pxy, Qxy, 65);
 
-    cx_edwards_compress_point(CX_CURVE_Ed25519, Pxy, sizeof(Pxy));
+    cx_edwards_compress_point(CX_CURVE_Ed25519, Pxy, 65);
     memmove(W, &Pxy[1], 32);
+    oxen_scratch_release(mark);
 }
 
 /* ----------------------------------------------------------------------- */
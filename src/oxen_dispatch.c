@@ -72,6 +72,7 @@ int check_ins_access(void) {
     switch (G_oxen_state.io_ins) {
         case INS_LOCK_DISPLAY:
         case INS_RESET:
+        case INS_HELLO:
         case INS_GET_NETWORK:
         case INS_RESET_NETWORK:
         case INS_PUT_KEY:
@@ -96,6 +97,7 @@ int check_ins_access(void) {
         case INS_GET_SUBADDRESS:
         case INS_GET_SUBADDRESS_SPEND_PUBLIC_KEY:
         case INS_GET_SUBADDRESS_SECRET_KEY:
+        case INS_SUBADDRESS_TABLE:
         case INS_UNBLIND:
         case INS_ENCRYPT_PAYMENT_ID:
         case INS_GET_TX_PROOF:
@@ -105,11 +107,15 @@ int check_ins_access(void) {
 
         case INS_OPEN_TX:
         case INS_SET_SIGNATURE_MODE:
+        case INS_SET_POLICY:
+        case INS_RESERVE_PROOF:
+        case INS_SIGN_MESSAGE:
             if (os_global_pin_is_validated() != PIN_VERIFIED) {
                 return SW_SECURITY_PIN_LOCKED;
             }
             return SW_OK;
 
+        case INS_GET_ADDITIONAL_KEY:
         case INS_GEN_TXOUT_KEYS:
         case INS_PREFIX_HASH:
         case INS_BLIND:
@@ -136,6 +142,24 @@ int monero_dispatch(void) {
         return sw;
     }
 
+    if (G_oxen_state.io_ins == INS_RESET || G_oxen_state.io_ins == INS_LOCK_DISPLAY) {
+        // These always go through: they abort the tx, and dismiss its output prompt if one is up
+        G_oxen_state.ux_deny_pending = 0;
+        if (G_oxen_state.ux_pending) {
+            monero_reset_tx(1);
+        }
+    } else if (G_oxen_state.ux_deny_pending) {
+        // A rejected output prompt that had no command held back is reported on the next one
+        G_oxen_state.ux_deny_pending = 0;
+        monero_io_discard(0);
+        return SW_DENY;
+    } else if (G_oxen_state.ux_pending && G_oxen_state.io_ins != INS_VALIDATE) {
+        // Otherwise only more VALIDATE commands can be processed while an output prompt is up
+        monero_io_discard(0);
+        return SW_COMMAND_NOT_ALLOWED;
+    }
+
+    oxen_scratch_reset();
     G_oxen_state.options = monero_io_fetch_u8();
 
     sw = 0x6F01;
@@ -147,6 +171,9 @@ int monero_dispatch(void) {
         case INS_LOCK_DISPLAY:
             sw = monero_apdu_lock();
             break;
+        case INS_HELLO:
+            sw = oxen_apdu_hello();
+            break;
         case INS_GET_NETWORK:
             sw = monero_apdu_get_network();
             break;
@@ -218,15 +245,51 @@ int monero_dispatch(void) {
         case INS_GET_SUBADDRESS_SECRET_KEY:
             sw = monero_apdu_get_subaddress_secret_key();
             break;
+        case INS_SUBADDRESS_TABLE:
+            if (G_oxen_state.tx_in_progress) {
+                THROW(SW_COMMAND_NOT_ALLOWED);
+            }
+            // The size to confirm shares its space with the state of the other sessions
+            if (G_oxen_state.io_p1 == 1 && G_oxen_state.tx_state_ins != 0) {
+                THROW(SW_COMMAND_NOT_ALLOWED);
+            }
+            sw = oxen_apdu_subaddr_table();
+            break;
 
         /* --- PARSE --- */
         case INS_UNBLIND:
             sw = monero_apdu_unblind();
             break;
 
+        /* --- POLICY --- */
+        case INS_SET_POLICY:
+            // The policy can't change under a tx, and each change is a single command
+            if (G_oxen_state.tx_in_progress || G_oxen_state.tx_state_ins != 0) {
+                THROW(SW_COMMAND_NOT_ALLOWED);
+            }
+            if (G_oxen_state.io_p2 != 0) THROW(SW_WRONG_P1P2);
+            sw = oxen_apdu_set_policy();
+            break;
+
         /* --- PROOF --- */
         case INS_GET_TX_PROOF:
-            sw = monero_apdu_get_tx_proof();
+            if (OXEN_IO_P_EQUALS(0, 0)) {
+                sw = monero_apdu_get_tx_proof();
+                break;
+            }
+            // Batch: the session data shares its space with the tx state
+            if (G_oxen_state.tx_in_progress) THROW(SW_COMMAND_NOT_ALLOWED);
+            // [1,0] (re)sets the message and recipient: from idle or within the batch
+            if (OXEN_IO_P_EQUALS(1, 0) &&
+                (G_oxen_state.tx_state_ins == 0 || G_oxen_state.tx_state_ins == INS_GET_TX_PROOF))
+                sw = oxen_apdu_get_tx_proof_batch();
+            // [2,0] proofs follow a [1,0]
+            else if (OXEN_IO_P_EQUALS(2, 0) && G_oxen_state.tx_state_ins == INS_GET_TX_PROOF)
+                sw = oxen_apdu_get_tx_proof_batch();
+            else
+                THROW(SW_COMMAND_NOT_ALLOWED);
+
+            update_protocol();
             break;
 
         /// This call will only work when we have an open transaction *and* it is recognized as a /
@@ -242,6 +305,22 @@ int monero_dispatch(void) {
 
             /* --- START TX --- */
         case INS_OPEN_TX:
+            // [OPEN_TX, 2, 0] opens the next tx of the session, once the current one has its
+            // CLSAGs done ([CLSAG, 3, 0] or a completed batch [CLSAG, 5, 0]) and no prepared input
+            // is left unsigned.
+            if (G_oxen_state.io_p1 == 2) {
+                if (!G_oxen_state.tx_in_progress ||
+                    !(OXEN_TX_STATE_INS_P_EQUALS(INS_CLSAG, 3, 0) ||
+                      OXEN_TX_STATE_INS_P_EQUALS(INS_CLSAG, 5, 0)) ||
+                    G_oxen_state.clsag_unsigned ||
+                    G_oxen_state.clsag_slot_signed != G_oxen_state.clsag_slot_cnt) {
+                    THROW(SW_COMMAND_NOT_ALLOWED);
+                }
+                if (G_oxen_state.io_p2 != 0) THROW(SW_WRONG_P1P2);
+                sw = monero_apdu_open_subtx();
+                update_protocol();
+                break;
+            }
             // state machine check
             if (!(G_oxen_state.tx_state_ins == 0 ||
                   G_oxen_state.tx_state_ins == INS_GEN_ONS_SIGNATURE)) {
@@ -273,7 +352,8 @@ int monero_dispatch(void) {
             // 1. state machine check
             if (G_oxen_state.tx_in_progress == 1) {
                 if ((G_oxen_state.tx_state_ins != INS_OPEN_TX) &&
-                    (G_oxen_state.tx_state_ins != INS_ENCRYPT_PAYMENT_ID)) {
+                    (G_oxen_state.tx_state_ins != INS_ENCRYPT_PAYMENT_ID) &&
+                    (G_oxen_state.tx_state_ins != INS_GET_ADDITIONAL_KEY)) {
                     THROW(SW_COMMAND_NOT_ALLOWED);
                 }
                 if (!OXEN_IO_P_EQUALS(0, 0)) THROW(SW_WRONG_P1P2);
@@ -285,12 +365,37 @@ int monero_dispatch(void) {
             }
             break;
 
+            /* --- ADDITIONAL TX KEYS --- */
+        case INS_GET_ADDITIONAL_KEY:
+            // 1. state machine check
+            if ((G_oxen_state.tx_state_ins == INS_OPEN_TX) ||
+                (G_oxen_state.tx_state_ins == INS_ENCRYPT_PAYMENT_ID)) {
+                // First page: [0,1] of a multi-page request, or [0,0] for a single page
+                if (G_oxen_state.io_p2 > 1) THROW(SW_SUBCOMMAND_NOT_ALLOWED);
+            } else if (G_oxen_state.tx_state_ins == INS_GET_ADDITIONAL_KEY) {
+                // Nothing follows the last page ([0,0]); other pages must follow the previous one
+                if (G_oxen_state.tx_state_p2 == 0 ||
+                    !(G_oxen_state.io_p2 == 0 ||
+                      G_oxen_state.io_p2 ==
+                          (G_oxen_state.tx_state_p2 < 255 ? G_oxen_state.tx_state_p2 + 1 : 1)))
+                    THROW(SW_SUBCOMMAND_NOT_ALLOWED);
+            } else {
+                THROW(SW_COMMAND_NOT_ALLOWED);
+            }
+            if (G_oxen_state.io_p1 != 0) THROW(SW_WRONG_P1P2);
+
+            // 2. command process
+            sw = oxen_apdu_get_additional_keys();
+            update_protocol();
+            break;
+
             /* --- TX OUT KEYS --- */
         case INS_GEN_TXOUT_KEYS:
             // 1. state machine check
             if ((G_oxen_state.tx_state_ins != INS_OPEN_TX) &&
                 (G_oxen_state.tx_state_ins != INS_GEN_TXOUT_KEYS) &&
-                (G_oxen_state.tx_state_ins != INS_ENCRYPT_PAYMENT_ID)) {
+                (G_oxen_state.tx_state_ins != INS_ENCRYPT_PAYMENT_ID) &&
+                (G_oxen_state.tx_state_ins != INS_GET_ADDITIONAL_KEY)) {
                 THROW(SW_COMMAND_NOT_ALLOWED);
             }
             if (!OXEN_IO_P_EQUALS(0, 0)) THROW(SW_WRONG_P1P2);
@@ -350,7 +455,33 @@ int monero_dispatch(void) {
 
             /* --- BLIND --- */
         case INS_BLIND:
-            // 1. state machine check
+            // Batched commitment mask + blind of all the outputs: [BLIND,1,x]
+            if (G_oxen_state.io_p1 == 1) {
+                // 1. state machine check: the first page comes after the prefix hash (or after
+                // separate commitment masks); next pages must follow the previous one.
+                if (OXEN_TX_STATE_INS_P_EQUALS(INS_PREFIX_HASH, 2, 0) ||
+                    G_oxen_state.tx_state_ins == INS_GEN_COMMITMENT_MASK) {
+                    if (G_oxen_state.io_p2 > 1) THROW(SW_SUBCOMMAND_NOT_ALLOWED);
+                } else if (G_oxen_state.tx_state_ins == INS_BLIND &&
+                           G_oxen_state.tx_state_p1 == 1 && G_oxen_state.tx_state_p2 != 0) {
+                    if (!(G_oxen_state.io_p2 == 0 ||
+                          G_oxen_state.io_p2 == (G_oxen_state.tx_state_p2 < 255
+                                                     ? G_oxen_state.tx_state_p2 + 1
+                                                     : 1)))
+                        THROW(SW_SUBCOMMAND_NOT_ALLOWED);
+                } else {
+                    THROW(SW_COMMAND_NOT_ALLOWED);
+                }
+                // 2. command process
+                sw = oxen_apdu_blind_batch();
+                update_protocol();
+                break;
+            }
+
+            // 1. state machine check: not in the middle of a batch
+            if (G_oxen_state.tx_state_ins == INS_BLIND && G_oxen_state.tx_state_p2 != 0) {
+                THROW(SW_COMMAND_NOT_ALLOWED);
+            }
             if (G_oxen_state.tx_sig_mode == TRANSACTION_CREATE_FAKE) {
             } else if (G_oxen_state.tx_sig_mode == TRANSACTION_CREATE_REAL) {
                 if ((G_oxen_state.tx_state_ins != INS_GEN_COMMITMENT_MASK) &&
@@ -370,11 +501,15 @@ int monero_dispatch(void) {
 
             /* --- VALIDATE/PREHASH --- */
         case INS_VALIDATE:
-            // 1. state machine check
+            // 1. state machine check: after the last blind, i.e. a single [BLIND,0,0] or the last
+            // page [BLIND,1,0] of a batch
             if ((G_oxen_state.tx_state_ins != INS_BLIND) &&
                 (G_oxen_state.tx_state_ins != INS_VALIDATE)) {
                 THROW(SW_COMMAND_NOT_ALLOWED);
             }
+            if (G_oxen_state.tx_state_ins == INS_BLIND && G_oxen_state.tx_state_p2 != 0) {
+                THROW(SW_COMMAND_NOT_ALLOWED);
+            }
             // init PREHASH state machine
             if (G_oxen_state.tx_state_ins == INS_BLIND) {
                 G_oxen_state.tx_state_ins = INS_VALIDATE;
@@ -411,26 +546,46 @@ int monero_dispatch(void) {
 
         /* --- CLSAG --- */
         case INS_CLSAG:
-            // If we are going to [CLSAG, 1, 0] then we must be coming from either [VALIDATE, 3] or
-            // [CLSAG, 3, 0]
-            if (OXEN_IO_P_EQUALS(1, 0)) {
+            // If we are going to [CLSAG, 1, 0] (or [CLSAG, 4, 0], the batched version) then we must
+            // be coming from either [VALIDATE, 3], [CLSAG, 3, 0] or a completed batch
+            // [CLSAG, 5, 0]; [CLSAG, 4, 0] can also follow [CLSAG, 4, 0] to prepare the next input
+            // of the batch.
+            if (OXEN_IO_P_EQUALS(1, 0) || OXEN_IO_P_EQUALS(4, 0)) {
                 if ((G_oxen_state.tx_state_ins == INS_VALIDATE && G_oxen_state.tx_state_p1 == 3) ||
-                    OXEN_TX_STATE_INS_P_EQUALS(INS_CLSAG, 3, 0))
-                    sw = monero_apdu_clsag_prepare();
+                    OXEN_TX_STATE_INS_P_EQUALS(INS_CLSAG, 3, 0) ||
+                    OXEN_TX_STATE_INS_P_EQUALS(INS_CLSAG, 5, 0) ||
+                    (G_oxen_state.io_p1 == 4 && OXEN_TX_STATE_INS_P_EQUALS(INS_CLSAG, 4, 0)))
+                    sw = G_oxen_state.io_p1 == 1 ? monero_apdu_clsag_prepare()
+                                                 : oxen_apdu_clsag_prepare_slot();
                 else
                     THROW(SW_SUBCOMMAND_NOT_ALLOWED);
             } else if (G_oxen_state.tx_state_ins == INS_CLSAG) {
                 // Transitioning between CLSAG states
 
-                // [1,0]->[2,x] or [2,x]->[2,y] (oxen_clsag.c does x/y validation)
-                if ((OXEN_TX_STATE_P_EQUALS(1, 0) || G_oxen_state.tx_state_p1 == 2) &&
+                // [1,0]->[2,x], [4,0]->[2,x] or [2,x]->[2,y] (oxen_clsag.c does x/y validation)
+                if ((OXEN_TX_STATE_P_EQUALS(1, 0) || OXEN_TX_STATE_P_EQUALS(4, 0) ||
+                     G_oxen_state.tx_state_p1 == 2) &&
                     G_oxen_state.io_p1 == 2)
                     sw = monero_apdu_clsag_hash();
 
                 // [2,0]->[3,0] - sign
-                else if (OXEN_TX_STATE_P_EQUALS(2, 0) && OXEN_IO_P_EQUALS(3, 0))
+                else if (OXEN_TX_STATE_P_EQUALS(2, 0) && OXEN_IO_P_EQUALS(3, 0) &&
+                         G_oxen_state.clsag_slot_cnt == 0)
                     sw = monero_apdu_clsag_sign();
 
+                // [2,0]->[5,x] - sign the batch, once every slot has been hashed; [5,x]->[5,y]
+                // for the next pages
+                else if (G_oxen_state.io_p1 == 5 &&
+                         ((OXEN_TX_STATE_P_EQUALS(2, 0) && G_oxen_state.io_p2 <= 1 &&
+                           G_oxen_state.clsag_slot_cnt &&
+                           G_oxen_state.clsag_slot_hashed == G_oxen_state.clsag_slot_cnt) ||
+                          (G_oxen_state.tx_state_p1 == 5 && G_oxen_state.tx_state_p2 != 0 &&
+                           (G_oxen_state.io_p2 == 0 ||
+                            G_oxen_state.io_p2 == (G_oxen_state.tx_state_p2 < 255
+                                                       ? G_oxen_state.tx_state_p2 + 1
+                                                       : 1)))))
+                    sw = oxen_apdu_clsag_sign_slots();
+
                 else
                     THROW(SW_SUBCOMMAND_NOT_ALLOWED);
             } else {
@@ -440,17 +595,65 @@ int monero_dispatch(void) {
             update_protocol();
             break;
 
+        /* --- Reserve proof --- */
+        case INS_RESERVE_PROOF:
+            // The session data shares its space with the tx state
+            if (G_oxen_state.tx_in_progress) THROW(SW_COMMAND_NOT_ALLOWED);
+            // [0,0] starts a session: must not be in the middle of something else
+            if (OXEN_IO_P_EQUALS(0, 0) && G_oxen_state.tx_state_ins == 0)
+                sw = oxen_apdu_reserve_proof();
+            // [0,0] -> [1,0] -> [1,0] ... -> [2,0]
+            else if ((OXEN_IO_P_EQUALS(1, 0) || OXEN_IO_P_EQUALS(2, 0)) &&
+                     G_oxen_state.tx_state_ins == INS_RESERVE_PROOF &&
+                     G_oxen_state.tx_state_p1 != 2)
+                sw = oxen_apdu_reserve_proof();
+            else
+                THROW(SW_COMMAND_NOT_ALLOWED);
+
+            update_protocol();
+            break;
+
+        /* --- Message signing --- */
+        case INS_SIGN_MESSAGE:
+            if (G_oxen_state.tx_in_progress) THROW(SW_COMMAND_NOT_ALLOWED);
+            // [0,N] starts a batch: must not be in the middle of something else
+            if (G_oxen_state.io_p1 == 0 && G_oxen_state.tx_state_ins == 0)
+                sw = oxen_apdu_sign_message();
+            // [0,N]->[1,x], [1,x]->[1,y], and [2,0]->[1,x] for the next message of the batch
+            else if (G_oxen_state.io_p1 == 1 && G_oxen_state.tx_state_ins == INS_SIGN_MESSAGE &&
+                     (G_oxen_state.tx_state_p1 == 0 || G_oxen_state.tx_state_p1 == 1 ||
+                      (G_oxen_state.tx_state_p1 == 2 && G_oxen_state.msg_batch_left)))
+                sw = oxen_apdu_sign_message();
+            // [1,0]->[2,0] signs the message
+            else if (OXEN_TX_STATE_INS_P_EQUALS(INS_SIGN_MESSAGE, 1, 0) && OXEN_IO_P_EQUALS(2, 0))
+                sw = oxen_apdu_sign_message();
+            else
+                THROW(SW_COMMAND_NOT_ALLOWED);
+
+            update_protocol();
+            break;
+
         /* --- Unlock --- */
         case INS_GEN_UNLOCK_SIGNATURE:
             if (G_oxen_state.tx_in_progress) THROW(SW_COMMAND_NOT_ALLOWED);
-            // Initialization: must not be in the middle of something else
-            if (OXEN_IO_P_EQUALS(0, 0) && G_oxen_state.tx_state_ins == 0)
+            // Initialization ([0,0], or [0,N] for a batch): must not be in the middle of something
+            // else
+            if (G_oxen_state.io_p1 == 0 && G_oxen_state.tx_state_ins == 0)
                 sw = oxen_apdu_generate_unlock_signature();
             else if (OXEN_IO_P_EQUALS(1, 0) &&
                      OXEN_TX_STATE_INS_P_EQUALS(INS_GEN_UNLOCK_SIGNATURE, 0, 0))
                 // [UNLOCK,1,0] is the post-confirmation step and must follow immediately the
                 // [UNLOCK,0,0] (which is where we ask for confirmation).
                 sw = oxen_apdu_generate_unlock_signature();
+            // Batch: [0,N] -> [1,1] -> [1,2] -> ... (wrapping from 255 to 1)
+            else if (G_oxen_state.io_p1 == 1 && G_oxen_state.io_p2 != 0 &&
+                     G_oxen_state.tx_state_ins == INS_GEN_UNLOCK_SIGNATURE &&
+                     G_oxen_state.tx_state_p2 != 0 &&
+                     ((G_oxen_state.tx_state_p1 == 0 && G_oxen_state.io_p2 == 1) ||
+                      (G_oxen_state.tx_state_p1 == 1 &&
+                       G_oxen_state.io_p2 ==
+                           (G_oxen_state.tx_state_p2 < 255 ? G_oxen_state.tx_state_p2 + 1 : 1))))
+                sw = oxen_apdu_generate_unlock_signature();
             else
                 THROW(SW_COMMAND_NOT_ALLOWED);
 
@@ -460,12 +663,15 @@ int monero_dispatch(void) {
         /* --- ONS --- */
         case INS_GEN_ONS_SIGNATURE:
             if (G_oxen_state.tx_in_progress) THROW(SW_COMMAND_NOT_ALLOWED);
-            // Initialization: must not be in the middle of something else
-            if (OXEN_IO_P_EQUALS(0, 0) && G_oxen_state.tx_state_ins == 0)
+            // Initialization ([0,0], or [0,N] for a batch): must not be in the middle of something
+            // else
+            if (G_oxen_state.io_p1 == 0 && G_oxen_state.tx_state_ins == 0)
                 sw = oxen_apdu_generate_lns_hash();
-            // [0,0]->[1,x] or [1,x]->[1,y] -- we receive data to hash in multiple parts
+            // [0,N]->[1,x] or [1,x]->[1,y] -- we receive data to hash in multiple parts; in a
+            // batch, [2,0]->[1,x] starts the next record
             else if (G_oxen_state.tx_state_ins == INS_GEN_ONS_SIGNATURE &&
-                     (OXEN_TX_STATE_P_EQUALS(0, 0) || G_oxen_state.tx_state_p1 == 1) &&
+                     (G_oxen_state.tx_state_p1 == 0 || G_oxen_state.tx_state_p1 == 1 ||
+                      (G_oxen_state.tx_state_p1 == 2 && G_oxen_state.lns_batch_left)) &&
                      G_oxen_state.io_p1 == 1)
                 sw = oxen_apdu_generate_lns_hash();
             // [1,0] -> [2,0] gives the account indices and uses the hash built in the [1,x] steps
@@ -17,6 +17,8 @@
  *  limitations under the License.
  *****************************************************************************/
 
+#include <stddef.h>
+
 #include "os.h"
 #include "cx.h"
 #include "oxen_types.h"
@@ -38,8 +40,36 @@ const unsigned char C_FAKE_SEC_SPEND_KEY[32] = {
 /* ----------------------------------------------------------------------- */
 /* --- Boot                                                            --- */
 /* ----------------------------------------------------------------------- */
+// Binds the derived keys, SPK and short address to the NV settings they were derived from
+static void oxen_keys_tag(unsigned char* tag) {
+    unsigned char c;
+
+    // Not policy_reserved: it changes with every tx the policy covers
+    cx_keccak_init(&G_oxen_state.keccak, 256);
+    oxen_hash_update(&G_oxen_state.keccak, G_oxen_state.keys, sizeof(G_oxen_state.keys));
+    oxen_hash_update(&G_oxen_state.keccak,
+                     (unsigned char*) &G_oxen_state.spk,
+                     sizeof(G_oxen_state.spk));
+    oxen_hash_update(&G_oxen_state.keccak,
+                     (unsigned char*) G_oxen_state.ux_wallet_public_short_address,
+                     sizeof(G_oxen_state.ux_wallet_public_short_address));
+    c = N_oxen_state->network_id;
+    oxen_hash_update(&G_oxen_state.keccak, &c, 1);
+    c = N_oxen_state->key_mode;
+    oxen_hash_update(&G_oxen_state.keccak, &c, 1);
+    oxen_hash_update(&G_oxen_state.keccak, (unsigned char*) N_oxen_state->view_priv, 32);
+    oxen_hash_update(&G_oxen_state.keccak, (unsigned char*) N_oxen_state->spend_priv, 32);
+    oxen_hash_final(&G_oxen_state.keccak, tag);
+}
+
+// Forces the next monero_init() to derive the keys again
+void oxen_forget_keys(void) {
+    memset(G_oxen_state.keys_tag, 0, sizeof(G_oxen_state.keys_tag));
+}
+
 void monero_init(void) {
-    memset(&G_oxen_state, 0, sizeof(oxen_v_state_t));
+    unsigned char tag[32];
+    unsigned char warm;
 
     // first init ?
     if (memcmp((void*) N_oxen_state->magic, (void*) C_MAGIC, sizeof(C_MAGIC)) != 0) {
@@ -50,14 +80,24 @@ void monero_init(void) {
 #endif
     }
 
+    oxen_keys_tag(tag);
+    warm = memcmp(tag, G_oxen_state.keys_tag, 32) == 0;
+    memset(&G_oxen_state, 0, warm ? offsetof(oxen_v_state_t, keys_tag) : sizeof(oxen_v_state_t));
+
     G_oxen_state.protocol = 0xff;
     G_oxen_state.protocol_barrier = PROTOCOL_UNLOCKED;
 
-    // load key
-    monero_init_private_key();
+    if (warm) {
+        G_oxen_state.key_set = 1;
+    } else {
+        // load key
+        monero_init_private_key();
 
-    // ux conf
-    monero_init_ux();
+        // ux conf
+        monero_init_ux();
+
+        oxen_keys_tag(G_oxen_state.keys_tag);
+    }
 
     // Let's go!
     G_oxen_state.state = STATE_IDLE;
@@ -70,11 +110,51 @@ void monero_init(void) {
 /* --- init private keys                                               --- */
 /* ----------------------------------------------------------------------- */
 void monero_wipe_private_key(void) {
+    oxen_forget_keys();
     memset(G_oxen_state.keys, 0, sizeof(G_oxen_state.keys));
     memset(&G_oxen_state.spk, 0, sizeof(G_oxen_state.spk));
     G_oxen_state.key_set = 0;
 }
 
+// Binds the cached public keys and address to the private keys and network.  Uses its own hasher:
+// this runs when the PIN gets validated, possibly in the middle of a tx.
+static void oxen_pub_cache_check(unsigned char* check) {
+    cx_sha256_t sha256;
+    unsigned char c = N_oxen_state->network_id;
+
+    cx_sha256_init(&sha256);
+    oxen_hash_update(&sha256, G_oxen_state.view_priv, 32);
+    oxen_hash_update(&sha256, G_oxen_state.spend_priv, 32);
+    oxen_hash_update(&sha256, &c, 1);
+    oxen_hash_update(&sha256, (unsigned char*) N_oxen_state->cached_view_pub, 32);
+    oxen_hash_update(&sha256, (unsigned char*) N_oxen_state->cached_spend_pub, 32);
+    oxen_hash_update(&sha256,
+                     (unsigned char*) N_oxen_state->cached_address,
+                     sizeof(N_oxen_state->cached_address));
+    c = N_oxen_state->cached_address_len;
+    oxen_hash_update(&sha256, &c, 1);
+    oxen_hash_final(&sha256, check);
+}
+
+static unsigned char oxen_pub_cache_valid(void) {
+    unsigned char check[32];
+
+    oxen_pub_cache_check(check);
+    return memcmp(check, (void*) N_oxen_state->pub_cache_check, 32) == 0;
+}
+
+static void oxen_pub_cache_store(const char* address, unsigned char address_len) {
+    unsigned char check[32];
+
+    if (address_len > sizeof(N_oxen_state->cached_address)) return;
+    nvm_write((void*) N_oxen_state->cached_view_pub, G_oxen_state.view_pub, 32);
+    nvm_write((void*) N_oxen_state->cached_spend_pub, G_oxen_state.spend_pub, 32);
+    nvm_write((void*) N_oxen_state->cached_address, (void*) address, address_len);
+    nvm_write((void*) &N_oxen_state->cached_address_len, &address_len, 1);
+    oxen_pub_cache_check(check);
+    nvm_write((void*) N_oxen_state->pub_cache_check, check, 32);
+}
+
 void monero_init_private_key(void) {
     unsigned int path[5];
     unsigned char seed[32];
@@ -113,9 +193,13 @@ void monero_init_private_key(void) {
             THROW(SW_SECURITY_LOAD_KEY);
             return;
     }
-    monero_ecmul_G(G_oxen_state.view_pub, G_oxen_state.view_priv);
-
-    monero_ecmul_G(G_oxen_state.spend_pub, G_oxen_state.spend_priv);
+    if (oxen_pub_cache_valid()) {
+        memmove(G_oxen_state.view_pub, (void*) N_oxen_state->cached_view_pub, 32);
+        memmove(G_oxen_state.spend_pub, (void*) N_oxen_state->cached_spend_pub, 32);
+    } else {
+        monero_ecmul_G(G_oxen_state.view_pub, G_oxen_state.view_priv);
+        monero_ecmul_G(G_oxen_state.spend_pub, G_oxen_state.spend_priv);
+    }
 
     // generate key protection
     monero_aes_derive(&G_oxen_state.spk, chain, G_oxen_state.view_priv, G_oxen_state.spend_priv);
@@ -127,11 +211,19 @@ void monero_init_private_key(void) {
 /* ---  Set up ui/ux                                                   --- */
 /* ----------------------------------------------------------------------- */
 void monero_init_ux(void) {
-    unsigned char wallet_len = oxen_wallet_address(G_oxen_state.ux_address,
-                                                   G_oxen_state.view_pub,
-                                                   G_oxen_state.spend_pub,
-                                                   0,
-                                                   NULL);
+    unsigned char wallet_len;
+
+    if (oxen_pub_cache_valid()) {
+        wallet_len = N_oxen_state->cached_address_len;
+        memmove(G_oxen_state.ux_address, (void*) N_oxen_state->cached_address, wallet_len);
+    } else {
+        wallet_len = oxen_wallet_address(G_oxen_state.ux_address,
+                                         G_oxen_state.view_pub,
+                                         G_oxen_state.spend_pub,
+                                         0,
+                                         NULL);
+        oxen_pub_cache_store(G_oxen_state.ux_address, wallet_len);
+    }
 
     memmove(G_oxen_state.ux_wallet_public_short_address, G_oxen_state.ux_address, 7);
     G_oxen_state.ux_wallet_public_short_address[7] = '.';
@@ -180,7 +272,7 @@ const char* const oxen_supported_client[] = {
 };
 #define OXEN_SUPPORTED_CLIENT_SIZE (sizeof(oxen_supported_client) / sizeof(char*))
 
-int monero_apdu_reset(void) {
+static void oxen_check_client_version(void) {
     unsigned short client_version_len;
     char client_version[16];
     client_version_len = G_oxen_state.io_length - G_oxen_state.io_offset;
@@ -201,6 +293,10 @@ int monero_apdu_reset(void) {
     if (i == OXEN_SUPPORTED_CLIENT_SIZE) {
         THROW(SW_CLIENT_NOT_SUPPORTED);
     }
+}
+
+int monero_apdu_reset(void) {
+    oxen_check_client_version();
 
     monero_io_discard(0);
     monero_init();
@@ -210,6 +306,69 @@ int monero_apdu_reset(void) {
     return SW_OK;
 }
 
+/* ----------------------------------------------------------------------- */
+/* --- HELLO                                                           --- */
+/* ----------------------------------------------------------------------- */
+/*
+ * Everything a wallet needs when it opens, in one exchange instead of RESET, GET_NETWORK, GET_KEY
+ * (public and view keys), GET_CHACHA8_PREKEY.  Unlike RESET this keeps the loaded keys: only a tx
+ * in progress is dropped.
+ *
+ * [HELLO, 0, 0]: client_version -> version(3) || nettype(1) || capabilities(4) || view_pub(32) ||
+ *     spend_pub(32) || has_view_key(1) || [view_priv(32)] || address_len(1) || address
+ *     The view key is only included when it can be exported without prompting (already accepted in
+ *     this session, or "always export" mode); otherwise GET_KEY p1=2 is still needed.
+ * [HELLO, 1, 0]: -> chacha8 prekey, as GET_CHACHA8_PREKEY
+ */
+int oxen_apdu_hello(void) {
+    unsigned char wallet_len;
+
+    switch (G_oxen_state.io_p1) {
+        case 0:
+            oxen_check_client_version();
+            monero_io_discard(0);
+            if (G_oxen_state.tx_in_progress) {
+                monero_reset_tx(1);
+            }
+            clear_protocol();
+
+            monero_io_insert_u8(OXEN_VERSION_MAJOR);
+            monero_io_insert_u8(OXEN_VERSION_MINOR);
+            monero_io_insert_u8(OXEN_VERSION_MICRO);
+            monero_io_insert_u8(oxen_nettype());
+            monero_io_insert_u32(OXEN_CAP_CLSAG_SLOTS | OXEN_CAP_OPEN_SUBTX | OXEN_CAP_POLICY |
+                                 OXEN_CAP_PROMPT_PIPELINE | OXEN_CAP_SUBADDR_TABLE |
+                                 OXEN_CAP_BATCH_UNLOCK | OXEN_CAP_BATCH_ONS |
+                                 OXEN_CAP_BATCH_TX_PROOF | OXEN_CAP_RESERVE_PROOF |
+                                 OXEN_CAP_SIGN_MESSAGE);
+            monero_io_insert(G_oxen_state.view_pub, 32);
+            monero_io_insert(G_oxen_state.spend_pub, 32);
+            if (N_oxen_state->viewkey_export_mode == VIEWKEY_EXPORT_ALWAYS_ALLOW) {
+                G_oxen_state.export_view_key = 1;
+            }
+            monero_io_insert_u8(G_oxen_state.export_view_key);
+            if (G_oxen_state.export_view_key) {
+                monero_io_insert(G_oxen_state.view_priv, 32);
+            }
+            wallet_len = oxen_wallet_address(
+                (char*) G_oxen_state.io_buffer + G_oxen_state.io_offset + 1,
+                G_oxen_state.view_pub,
+                G_oxen_state.spend_pub,
+                0,
+                NULL);
+            monero_io_insert_u8(wallet_len);
+            monero_io_inserted(wallet_len);
+            return SW_OK;
+
+        case 1:
+            return monero_apdu_get_chacha8_prekey();
+
+        default:
+            THROW(SW_WRONG_P1P2);
+    }
+    return SW_OK;
+}
+
 /* ----------------------------------------------------------------------- */
 /* --- LOCK                                                           --- */
 /* ----------------------------------------------------------------------- */
@@ -221,6 +380,10 @@ int monero_apdu_lock(void) {
 
 void monero_lock_and_throw(int sw) {
     G_oxen_state.protocol_barrier = PROTOCOL_LOCKED;
+    oxen_forget_keys();
+    oxen_drv_cache_wipe();
+    oxen_subaddr_key_wipe();
+    oxen_scratch_reset();
     snprintf(G_oxen_state.ux_info1, sizeof(G_oxen_state.ux_info1), "Security Err");
     snprintf(G_oxen_state.ux_info2, sizeof(G_oxen_state.ux_info2), "%x", sw);
     ui_menu_info_display();
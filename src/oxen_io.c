@@ -107,7 +107,12 @@ void monero_io_insert_hmac_for(unsigned char* buffer, int len, int type) {
         hmac[35] = 0;
         hmac[36] = 0;
     }
-    cx_hmac_sha256(G_oxen_state.hmac_key, 32, hmac, 37, hmac, 32);
+    cx_hmac_sha256(type == TYPE_ALPHA ? G_oxen_state.alpha_key : G_oxen_state.hmac_key,
+                   32,
+                   hmac,
+                   37,
+                   hmac,
+                   32);
     monero_io_insert(hmac, 32);
 }
 
@@ -213,7 +218,12 @@ static void monero_io_verify_hmac_for(const unsigned char* buffer,
         hmac[35] = 0;
         hmac[36] = 0;
     }
-    cx_hmac_sha256(G_oxen_state.hmac_key, 32, hmac, 37, hmac, 32);
+    cx_hmac_sha256(type == TYPE_ALPHA ? G_oxen_state.alpha_key : G_oxen_state.hmac_key,
+                   32,
+                   hmac,
+                   37,
+                   hmac,
+                   32);
     if (memcmp(hmac, expected_hmac, 32)) {
         monero_lock_and_throw(SW_SECURITY_HMAC);
     }
@@ -141,26 +141,25 @@ int monero_apdu_put_key(void) {
     return SW_OK;
 }
 
-int monero_apdu_get_network(void) {
-    // We sent back "OXEN" followed by the network type byte
-    monero_io_discard(1);
-    uint8_t nettype;
+unsigned char oxen_nettype(void) {
     switch (N_oxen_state->network_id) {
         case MAINNET:
-            nettype = 0;
-            break;
+            return 0;
         case TESTNET:
-            nettype = 1;
-            break;
+            return 1;
         case DEVNET:
-            nettype = 2;
-            break;
+            return 2;
         case FAKECHAIN:
-            nettype = 3;
-            break;
+            return 3;
         default:
-            nettype = 255;
+            return 255;
     }
+}
+
+int monero_apdu_get_network(void) {
+    // We sent back "OXEN" followed by the network type byte
+    monero_io_discard(1);
+    uint8_t nettype = oxen_nettype();
     monero_io_insert((const unsigned char *) "OXEN", 4);
     monero_io_insert(&nettype, 1);
     return SW_OK;
@@ -245,6 +244,18 @@ int monero_apdu_get_key(void) {
             monero_io_insert(G_oxen_state.view_priv, 32);
             monero_io_insert(G_oxen_state.spend_priv, 32);
             break;
+
+        // key derivation cache hits and misses
+        case 5:
+            monero_io_insert_u32(G_oxen_state.drv_cache_hits);
+            monero_io_insert_u32(G_oxen_state.drv_cache_misses);
+            break;
+
+        // scratch arena high-water mark and size (with canaries)
+        case 6:
+            monero_io_insert_u16(G_oxen_state.scratch_high);
+            monero_io_insert_u16(sizeof(G_oxen_state.scratch));
+            break;
 #endif
 
         default:
@@ -513,7 +524,11 @@ int monero_apdu_generate_key_image(
     monero_io_discard(0);
 
     // pub
-    monero_generate_key_image(image, pub, sec);
+    if (OXEN_TX_FAKE_MODE()) {
+        memmove(image, pub, 32);
+    } else {
+        monero_generate_key_image(image, pub, sec);
+    }
 
     // pub key
     monero_io_insert(image, 32);
@@ -551,50 +566,105 @@ static const unsigned char STAKE_UNLOCK_HASH[32] = {
 // Generate an unlock signature.  There are two steps here: the first (p1=0) asks for confirmation,
 // and if given, we store that and then allow the second (p1=1) to produce the signature.  We
 // require that that a transaction be open, and be an UNLOCK type.
+/*
+ * [UNLOCK, 0, 0] -> confirm, then [UNLOCK, 1, 0]: pub || wrapped sec -> signature
+ * [UNLOCK, 0, N] -> confirm "N stakes" once, then [UNLOCK, 1, 1], [UNLOCK, 1, 2], ...: up to
+ *     UNLOCK_BATCH_PER_APDU (pub || wrapped sec) entries each -> their signatures, N in total
+ */
+#define UNLOCK_BATCH_PER_APDU 2
 int oxen_apdu_generate_unlock_signature(void) {
     unsigned char signature[64];
-    unsigned char sec[32];
-    unsigned char *pub;
+    unsigned char sec[UNLOCK_BATCH_PER_APDU][32];
+    unsigned char pub[UNLOCK_BATCH_PER_APDU][32];
+    unsigned int n;
 
     if (G_oxen_state.io_p1 == 0) {
-        // Confirm the unlock with the user
+        // Confirm the unlock with the user, unless the signing policy covers unlocks
         monero_io_discard(1);
-        ui_menu_unlock_validation_display();
+        G_oxen_state.unlock_batch_left = G_oxen_state.io_p2;
+        if (oxen_policy_covers(TXTYPE_UNLOCK)) {
+            G_oxen_state.tx_special_confirmed = 1;
+            return SW_OK;
+        }
+        if (G_oxen_state.io_p2) {
+            snprintf(G_oxen_state.ux_addr_type,
+                     sizeof(G_oxen_state.ux_addr_type),
+                     G_oxen_state.io_p2 == 1 ? "%d stake" : "%d stakes",
+                     G_oxen_state.io_p2);
+            ui_menu_unlock_batch_validation_display();
+        } else {
+            ui_menu_unlock_validation_display();
+        }
         return 0;
     } else if (G_oxen_state.io_p1 != 1 || !G_oxen_state.tx_special_confirmed) {
         monero_lock_and_throw(SW_WRONG_DATA);
     }
 
     // fetch
-    pub = G_oxen_state.io_buffer + G_oxen_state.io_offset;
-    monero_io_fetch(NULL, 32);
-    monero_io_fetch_decrypt(sec, 32, TYPE_SCALAR);
+    if (G_oxen_state.io_p2 == 0) {
+        n = 1;
+    } else {
+        n = (G_oxen_state.io_length - G_oxen_state.io_offset) / (32 + 64);
+        if (n == 0 || n > UNLOCK_BATCH_PER_APDU ||
+            G_oxen_state.io_length - G_oxen_state.io_offset != n * (32 + 64)) {
+            THROW(SW_WRONG_LENGTH);
+        }
+        // Never more than what the user confirmed
+        if (n > G_oxen_state.unlock_batch_left) {
+            monero_lock_and_throw(SW_WRONG_DATA);
+        }
+        G_oxen_state.unlock_batch_left -= n;
+    }
+    for (unsigned int i = 0; i < n; i++) {
+        monero_io_fetch(pub[i], 32);
+        monero_io_fetch_decrypt(sec[i], 32, TYPE_SCALAR);
+    }
     monero_io_discard(0);
 
-    // sign
-    oxen_generate_signature(signature, (unsigned char *) STAKE_UNLOCK_HASH, pub, sec);
-
-    // return
-    monero_io_insert(signature, 64);
+    // sign and return
+    for (unsigned int i = 0; i < n; i++) {
+        oxen_generate_signature(signature, (unsigned char *) STAKE_UNLOCK_HASH, pub[i], sec[i]);
+        monero_io_insert(signature, 64);
+    }
     return SW_OK;
 }
+#undef UNLOCK_BATCH_PER_APDU
 
 // Generates an ONS hash
+/*
+ * [ONS, 0, 0] -> confirm, then [ONS, 1, x]... record data, [ONS, 2, 0]: subaddr index -> signature
+ * [ONS, 0, N] -> confirm "N records" once, then the same [1, x]... [2, 0] sequence for each of the
+ *     N records
+ */
 int oxen_apdu_generate_lns_hash(void) {
     if (G_oxen_state.io_p1 == 0) {
-        // Confirm the ONS initialization with the user
+        // Confirm the ONS initialization with the user, unless the signing policy covers ONS
         monero_io_discard(1);
-        ui_menu_lns_validation_display();
+        G_oxen_state.lns_batch_left = G_oxen_state.io_p2;
+        oxen_subaddr_key_wipe();
+        if (oxen_policy_covers(TXTYPE_ONS)) {
+            G_oxen_state.tx_special_confirmed = 1;
+            return SW_OK;
+        }
+        if (G_oxen_state.io_p2) {
+            snprintf(G_oxen_state.ux_addr_type,
+                     sizeof(G_oxen_state.ux_addr_type),
+                     G_oxen_state.io_p2 == 1 ? "%d record" : "%d records",
+                     G_oxen_state.io_p2);
+            ui_menu_lns_batch_validation_display();
+        } else {
+            ui_menu_lns_validation_display();
+        }
         return 0;
     } else if (G_oxen_state.io_p1 != 1 || !G_oxen_state.tx_special_confirmed) {
         monero_lock_and_throw(SW_WRONG_DATA);
     }
 
-    // We init hash if we just came off [0] (in which case current cmd must be [1,1] or [1,0], i.e.
-    // the first of multipart, or single-part.
-    if (G_oxen_state.tx_state_p1 == 0) {
+    // We init hash if we just came off [0] or off the [2] of the previous record of a batch (in
+    // which case current cmd must be [1,1] or [1,0], i.e. the first of multipart, or single-part.
+    if (G_oxen_state.tx_state_p1 != 1) {
         if (G_oxen_state.io_p2 > 1) THROW(SW_SUBCOMMAND_NOT_ALLOWED);
-        cx_blake2b_init(&G_oxen_state.blake2b, 256);
+        cx_blake2b_init(&G_oxen_state.lns_blake2b, 256);
         // Otherwise we are in the hashing step so make sure the piece we receive properly follows
     } else if (!(G_oxen_state.io_p2 == 0 ||  // this chunk is last, *or*:
                  G_oxen_state.io_p2 == (G_oxen_state.tx_state_p2 == 255
@@ -605,41 +675,63 @@ int oxen_apdu_generate_lns_hash(void) {
         THROW(SW_SUBCOMMAND_NOT_ALLOWED);
     }
 
-    oxen_hash_update(&G_oxen_state.blake2b,
+    oxen_hash_update(&G_oxen_state.lns_blake2b,
                      G_oxen_state.io_buffer + G_oxen_state.io_offset,
                      G_oxen_state.io_length - G_oxen_state.io_offset);
     monero_io_discard(1);
 
     if (G_oxen_state.io_p2 == 0)  // This was the last data piece
-        oxen_hash_final(&G_oxen_state.blake2b, G_oxen_state.lns_hash);
+        oxen_hash_final(&G_oxen_state.lns_blake2b, G_oxen_state.lns_hash);
 
     return SW_OK;
 }
 
-int oxen_apdu_generate_lns_signature(void) {
-    unsigned char subaddr_index[8];
-#define SKEY      &G_oxen_state.tmp[0]
-#define PKEY      &G_oxen_state.tmp[32]
-#define STMP      &G_oxen_state.tmp[64]
-#define SIGNATURE &G_oxen_state.tmp[64]
+void oxen_subaddr_key_wipe(void) {
+    memset(G_oxen_state.subaddr_key_sec, 0, 32);
+    G_oxen_state.subaddr_key_set = 0;
+}
 
-    monero_io_fetch(subaddr_index, 8);
-    monero_io_discard(1);
+// Loads the spend keys of the subaddress into subaddr_key_sec/subaddr_key_pub, unless they are
+// already there: batches (ONS records, reserve proofs) tend to stay on the same subaddress
+void oxen_subaddr_key_load(const unsigned char *subaddr_index) {
+    unsigned char stmp[32];
+
+    if (G_oxen_state.subaddr_key_set &&
+        memcmp(G_oxen_state.subaddr_key_index, subaddr_index, 8) == 0)
+        return;
 
     if (memcmp(subaddr_index, "\0\0\0\0\0\0\0\0", 8) == 0) {
-        memmove(SKEY, G_oxen_state.spend_priv, 32);
-        memmove(PKEY, G_oxen_state.spend_pub, 32);
+        memmove(G_oxen_state.subaddr_key_sec, G_oxen_state.spend_priv, 32);
+        memmove(G_oxen_state.subaddr_key_pub, G_oxen_state.spend_pub, 32);
     } else {
-        monero_get_subaddress_secret_key(STMP, G_oxen_state.view_priv, subaddr_index);
-        monero_addm(SKEY, STMP, G_oxen_state.spend_priv);
-        monero_ecmul_G(PKEY, SKEY);
+        monero_get_subaddress_secret_key(stmp, G_oxen_state.view_priv, subaddr_index);
+        monero_addm(G_oxen_state.subaddr_key_sec, stmp, G_oxen_state.spend_priv);
+        monero_ecmul_G(G_oxen_state.subaddr_key_pub, G_oxen_state.subaddr_key_sec);
+        memset(stmp, 0, 32);
     }
+    memmove(G_oxen_state.subaddr_key_index, subaddr_index, 8);
+    G_oxen_state.subaddr_key_set = 1;
+}
+
+int oxen_apdu_generate_lns_signature(void) {
+    unsigned char subaddr_index[8];
+    unsigned char signature[64];
 
-    oxen_generate_signature(SIGNATURE, G_oxen_state.lns_hash, PKEY, SKEY);
-    monero_io_insert(SIGNATURE, 64);
-    memset(G_oxen_state.tmp, 0, 128);
+    monero_io_fetch(subaddr_index, 8);
+    monero_io_discard(1);
+
+    oxen_subaddr_key_load(subaddr_index);
+    oxen_generate_signature(signature,
+                            G_oxen_state.lns_hash,
+                            G_oxen_state.subaddr_key_pub,
+                            G_oxen_state.subaddr_key_sec);
+    monero_io_insert(signature, 64);
     memset(G_oxen_state.lns_hash, 0, 32);
 
+    // The key is only kept while more records of the batch are to come
+    if (G_oxen_state.lns_batch_left) G_oxen_state.lns_batch_left--;
+    if (!G_oxen_state.lns_batch_left) oxen_subaddr_key_wipe();
+
     return SW_OK;
 }
 
@@ -730,6 +822,62 @@ int monero_apdu_get_subaddress_secret_key(/*const crypto::secret_key& sec, const
 /* ----------------------------------------------------------------------- */
 /* ---                                                                 --- */
 /* ----------------------------------------------------------------------- */
+// Returns true if the derivation of (pub, sec) is the change derivation precomputed at open time,
+// i.e. if it is either 8.a.R or 8.r.A for the tx key pair of the open transaction.  A fake tx has no
+// change derivation (its R is just a valid point), so it always derives.
+static int oxen_is_change_derivation(const unsigned char *pub, const unsigned char *sec) {
+    if (!G_oxen_state.tx_in_progress || OXEN_TX_FAKE_MODE() ||
+        cx_math_is_zero(G_oxen_state.change_derivation, 32))
+        return 0;
+    return (memcmp(pub, G_oxen_state.R, 32) == 0 &&
+            memcmp(sec, G_oxen_state.view_priv, 32) == 0) ||
+           (memcmp(pub, G_oxen_state.view_pub, 32) == 0 && memcmp(sec, G_oxen_state.r, 32) == 0);
+}
+
+// Additional tx secret keys generated on the device never leave it: r_i is derived from a random
+// per-tx seed and the output index, so the seed is all we need to keep in the tx state.
+static void oxen_additional_tx_key(unsigned char *r, unsigned int output_index) {
+    monero_derivation_to_scalar(r, G_oxen_state.additional_key_seed, output_index);
+}
+
+// Generates the additional tx keys of the next outputs of the open transaction.  The data is one
+// [is_subaddress(1) || Bout(32)] entry per output, in output index order, split over as many pages
+// as needed (p2 numbered as for INS_PREFIX_HASH).  We reply with the additional tx pubkeys of the
+// entries, r_i.Bout for a subaddress and r_i.G otherwise.  The keys are then selected in
+// INS_GEN_TXOUT_KEYS with need_additional_txkeys = 2 instead of being sent back encrypted.
+int oxen_apdu_get_additional_keys(void) {
+    unsigned int count, i;
+    unsigned char is_subaddress;
+    unsigned char Bout[32];
+    unsigned char sec[32];
+
+    count = monero_io_fetch_available() / 33;
+    if (count == 0 || count * 33 != (unsigned int) monero_io_fetch_available()) {
+        THROW(SW_WRONG_LENGTH);
+    }
+    if (G_oxen_state.tx_additional_key_cnt + count > 255) {
+        monero_lock_and_throw(SW_SECURITY_MAXOUTPUT_REACHED);
+    }
+
+    // Each 32-byte pubkey is written over the already consumed part of the (33-byte) entries
+    for (i = 0; i < count; i++) {
+        is_subaddress = monero_io_fetch_u8();
+        monero_io_fetch(Bout, 32);
+        oxen_additional_tx_key(sec, G_oxen_state.tx_additional_key_cnt++);
+        if (OXEN_TX_FAKE_MODE()) {
+            memmove(G_oxen_state.io_buffer + 32 * i, Bout, 32);
+        } else if (is_subaddress) {
+            monero_ecmul_k(G_oxen_state.io_buffer + 32 * i, Bout, sec);
+        } else {
+            monero_ecmul_G(G_oxen_state.io_buffer + 32 * i, sec);
+        }
+    }
+    memset(sec, 0, 32);
+
+    monero_io_discard(0);
+    monero_io_inserted(32 * count);
+    return SW_OK;
+}
 
 int monero_apu_generate_txout_keys(/*size_t tx_version, crypto::secret_key tx_sec, crypto::public_key Aout, crypto::public_key Bout, size_t output_index, bool is_change, bool is_subaddress, bool need_additional_key*/) {
     // IN
@@ -765,52 +913,62 @@ int monero_apu_generate_txout_keys(/*size_t tx_version, crypto::secret_key tx_se
     is_change = monero_io_fetch_u8();
     is_subaddress = monero_io_fetch_u8();
     need_additional_txkeys = monero_io_fetch_u8();
-    if (need_additional_txkeys) {
+    if (need_additional_txkeys == 2) {
+        // generated by INS_GET_ADDITIONAL_KEY; the host already has the pubkey
+        if (output_index >= G_oxen_state.tx_additional_key_cnt) {
+            THROW(SW_WRONG_DATA_RANGE);
+        }
+        oxen_additional_tx_key(additional_txkey_sec, output_index);
+    } else if (need_additional_txkeys) {
         monero_io_fetch_decrypt_key(additional_txkey_sec);
     }
 
-    // update outkeys hash control
-    if (G_oxen_state.tx_sig_mode == TRANSACTION_CREATE_REAL) {
-        oxen_hash_update(&G_oxen_state.sha256, Aout, 32);
-        oxen_hash_update(&G_oxen_state.sha256, Bout, 32);
-        oxen_hash_update(&G_oxen_state.sha256, &is_change, 1);
-    }
+    if (OXEN_TX_FAKE_MODE()) {
+        // No derivation: a keccak-only amount key, and Bout for the pubkeys
+        monero_derivation_to_scalar(amount_key, Bout, output_index);
+        memmove(additional_txkey_pub, Bout, 32);
+        memmove(out_eph_public_key, Bout, 32);
+    } else {
+        // make additional tx pubkey if necessary
+        if (need_additional_txkeys == 1) {
+            if (is_subaddress) {
+                monero_ecmul_k(additional_txkey_pub, Bout, additional_txkey_sec);
+            } else {
+                monero_ecmul_G(additional_txkey_pub, additional_txkey_sec);
+            }
+        } else {
+            memset(additional_txkey_pub, 0, 32);
+        }
 
-    // make additional tx pubkey if necessary
-    if (need_additional_txkeys) {
-        if (is_subaddress) {
-            monero_ecmul_k(additional_txkey_pub, Bout, additional_txkey_sec);
+        // derivation
+        if (is_change) {
+            if (oxen_is_change_derivation(txkey_pub, G_oxen_state.view_priv))
+                memmove(derivation, G_oxen_state.change_derivation, 32);
+            else
+                monero_generate_key_derivation(derivation, txkey_pub, G_oxen_state.view_priv);
         } else {
-            monero_ecmul_G(additional_txkey_pub, additional_txkey_sec);
+            monero_generate_key_derivation(
+                derivation,
+                Aout,
+                (is_subaddress && need_additional_txkeys) ? additional_txkey_sec : tx_key);
         }
-    } else {
-        memset(additional_txkey_pub, 0, 32);
-    }
 
-    // derivation
-    if (is_change) {
-        monero_generate_key_derivation(derivation, txkey_pub, G_oxen_state.view_priv);
-    } else {
-        monero_generate_key_derivation(
-            derivation,
-            Aout,
-            (is_subaddress && need_additional_txkeys) ? additional_txkey_sec : tx_key);
-    }
+        // compute amount key AKout (scalar1), version is always greater than 1
+        monero_derivation_to_scalar(amount_key, derivation, output_index);
+        // update outkeys transcript
+        if (G_oxen_state.tx_sig_mode == TRANSACTION_CREATE_REAL) {
+            oxen_transcript_absorb_output(Aout, Bout, is_change, amount_key);
+        }
 
-    // compute amount key AKout (scalar1), version is always greater than 1
-    monero_derivation_to_scalar(amount_key, derivation, output_index);
-    if (G_oxen_state.tx_sig_mode == TRANSACTION_CREATE_REAL) {
-        oxen_hash_update(&G_oxen_state.sha256, amount_key, 32);
+        // compute ephemeral output key
+        monero_derive_public_key(out_eph_public_key, derivation, output_index, Bout);
     }
 
-    // compute ephemeral output key
-    monero_derive_public_key(out_eph_public_key, derivation, output_index, Bout);
-
     // send all
     monero_io_discard(0);
     monero_io_insert_encrypt(amount_key, 32, TYPE_AMOUNT_KEY);
     monero_io_insert(out_eph_public_key, 32);
-    if (need_additional_txkeys) {
+    if (need_additional_txkeys == 1) {
         monero_io_insert(additional_txkey_pub, 32);
     }
     G_oxen_state.tx_output_cnt++;
@@ -834,7 +992,10 @@ int monero_apdu_encrypt_payment_id(void) {
     monero_io_discard(0);
 
     // Compute Dout
-    monero_generate_key_derivation(drv, pub, sec);
+    if (oxen_is_change_derivation(pub, sec))
+        memmove(drv, G_oxen_state.change_derivation, 32);
+    else
+        monero_generate_key_derivation(drv, pub, sec);
 
     // compute mask
     drv[32] = ENCRYPTED_PAYMENT_ID_TAIL;
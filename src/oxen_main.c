@@ -52,6 +52,8 @@ void monero_main(void) {
             }
             CATCH_OTHER(e) {
                 monero_reset_tx(1);
+                // Don't leave what the aborted command had in the arena (CLSAG secrets) around
+                oxen_scratch_reset();
                 if (((e & 0xF000) == 0x9000) || ((e & 0xFF00) == 0x6400)) {
                     sw = e;
                 } else {
@@ -0,0 +1,102 @@
+/*****************************************************************************
+ *   Ledger Oxen App.
+ *   (c) 2020 Oxen Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *****************************************************************************/
+
+/*
+ * Message signing.
+ *
+ * Signs arbitrary messages (e.g. proof of control challenges) with the spend key of the wallet or
+ * of one of its subaddresses.  The messages are hashed on the device, and the user approves a
+ * whole batch of them at once.
+ */
+
+#include "os.h"
+#include "cx.h"
+#include "oxen_types.h"
+#include "oxen_api.h"
+#include "oxen_vars.h"
+
+/* ----------------------------------------------------------------------- */
+/* ---                                                                 --- */
+/* ----------------------------------------------------------------------- */
+/*
+ * [SIGN_MESSAGE, 0, N]: confirms the signature of N messages (N > 0) with the user.
+ * [SIGN_MESSAGE, 1, x]: message data, in chunks [1, 1], [1, 2], ... [1, 0] (or just [1, 0]).
+ * [SIGN_MESSAGE, 2, 0]: subaddress index (8) -> signature(64) of keccak(message).
+ * The [1, x]... [2, 0] sequence is repeated for each of the N messages.
+ */
+int oxen_apdu_sign_message(void) {
+    unsigned char index[8];
+    unsigned char hash[32];
+    unsigned char signature[64];
+
+    switch (G_oxen_state.io_p1) {
+        case 0:
+            monero_io_discard(1);
+            if (G_oxen_state.io_p2 == 0) THROW(SW_WRONG_P1P2);
+            G_oxen_state.tx_special_confirmed = 0;
+            G_oxen_state.msg_batch_left = G_oxen_state.io_p2;
+            oxen_subaddr_key_wipe();
+            snprintf(G_oxen_state.ux_addr_type,
+                     sizeof(G_oxen_state.ux_addr_type),
+                     G_oxen_state.io_p2 == 1 ? "%d message" : "%d messages",
+                     G_oxen_state.io_p2);
+            ui_menu_sign_message_validation_display();
+            return 0;
+
+        case 1:
+            if (!G_oxen_state.tx_special_confirmed) monero_lock_and_throw(SW_WRONG_DATA);
+            // A new message starts after [0] or after the [2] of the previous one
+            if (G_oxen_state.tx_state_p1 != 1) {
+                if (G_oxen_state.io_p2 > 1) THROW(SW_SUBCOMMAND_NOT_ALLOWED);
+                cx_keccak_init(&G_oxen_state.message_keccak, 256);
+            } else if (!(G_oxen_state.io_p2 == 0 ||
+                         G_oxen_state.io_p2 == (G_oxen_state.tx_state_p2 == 255
+                                                    ? 1
+                                                    : G_oxen_state.tx_state_p2 + 1))) {
+                THROW(SW_SUBCOMMAND_NOT_ALLOWED);
+            }
+            oxen_hash_update(&G_oxen_state.message_keccak,
+                             G_oxen_state.io_buffer + G_oxen_state.io_offset,
+                             G_oxen_state.io_length - G_oxen_state.io_offset);
+            monero_io_discard(1);
+            return SW_OK;
+
+        case 2:
+            if (!G_oxen_state.tx_special_confirmed) monero_lock_and_throw(SW_WRONG_DATA);
+            monero_io_fetch(index, 8);
+            monero_io_discard(1);
+
+            oxen_hash_final(&G_oxen_state.message_keccak, hash);
+            oxen_subaddr_key_load(index);
+            oxen_generate_signature(signature,
+                                    hash,
+                                    G_oxen_state.subaddr_key_pub,
+                                    G_oxen_state.subaddr_key_sec);
+            monero_io_insert(signature, 64);
+
+            // The key is only kept while more messages of the batch are to come
+            if (--G_oxen_state.msg_batch_left == 0) {
+                oxen_subaddr_key_wipe();
+                G_oxen_state.tx_special_confirmed = 0;
+            }
+            return SW_OK;
+
+        default:
+            THROW(SW_WRONG_P1P2);
+    }
+    return SW_OK;
+}
@@ -107,24 +107,48 @@ const unsigned char encoded_block_sizes[] = {0, 2, 3, 5, 6, 7, 9, 10, 11};
 #define FULL_BLOCK_SIZE         8  //(sizeof(encoded_block_sizes) / sizeof(encoded_block_sizes[0]) - 1)
 #define FULL_ENCODED_BLOCK_SIZE 11  // encoded_block_sizes[full_block_size];
 
-static uint64_t uint_8be_to_64(const unsigned char* data, size_t size) {
-    uint64_t res = 0;
-    for (size_t i = 0; i < 8; i++) {
-        if (i >= size) break;
-        res <<= 8;
-        res |= data[i];
+/* ----------------------------------------------------------------------- */
+/* ---                     Division-free formatting                    --- */
+/* ----------------------------------------------------------------------- */
+/*
+ * 64-bit division is a software long division on the Nano cores (and even 32-bit division is on
+ * the Nano S), so numbers are formatted as big-endian byte strings divided one byte at a time.
+ * Each step only divides r < 256 * divisor, which a 32-bit multiply and shift does exactly.
+ */
+#define DIV10_STEP(r) (((r) * 0xCCCD) >> 19)  // exact for r < 81920
+#define DIV58_STEP(r) (((r) * 0x235) >> 15)   // exact for r < 14848
+
+// Divides the big-endian number num[0..len) in place by 10 or 58; returns the remainder
+unsigned int oxen_be_divmod(unsigned char* num, unsigned int len, unsigned int divisor) {
+    unsigned int r = 0;
+    unsigned int q;
+
+    // The steps are only exact for these two
+    if (divisor != 10 && divisor != 58) THROW(SW_SECURITY_INTERNAL);
+
+    for (unsigned int i = 0; i < len; i++) {
+        r = (r << 8) | num[i];
+        q = divisor == 58 ? DIV58_STEP(r) : DIV10_STEP(r);
+        num[i] = q;
+        r -= q * divisor;
     }
+    return r;
+}
 
-    return res;
+void oxen_uint64_to_be(uint64_t v, unsigned char* num) {
+    for (int i = 7; i >= 0; i--) {
+        num[i] = v & 0xff;
+        v >>= 8;
+    }
 }
 
 static void encode_block(const unsigned char* block, unsigned int size, char* res) {
-    uint64_t num = uint_8be_to_64(block, size);
+    unsigned char num[FULL_BLOCK_SIZE];
     int i = encoded_block_sizes[size];
+
+    memmove(num, block, size);
     while (i--) {
-        uint64_t remainder = num % alphabet_size;
-        num /= alphabet_size;
-        res[i] = alphabet[remainder];
+        res[i] = alphabet[oxen_be_divmod(num, size, alphabet_size)];
     }
 }
 
@@ -141,6 +165,7 @@ unsigned char oxen_wallet_address(char* str_b58,
                        ADDR_CHECKSUM_SIZE];
     unsigned char offset;
     unsigned short prefix;
+    unsigned char checksum_hash[32];
 
     // data[0] = N_oxen_state->network_id;
     switch (N_oxen_state->network_id) {
@@ -182,8 +207,8 @@ unsigned char oxen_wallet_address(char* str_b58,
         memmove(data + offset, paymentID, 8);
         offset += ADDR_PAYMENTID_SIZE;
     }
-    oxen_keccak_256(&G_oxen_state.keccak, data, offset, G_oxen_state.addr_checksum_hash);
-    memmove(data + offset, G_oxen_state.addr_checksum_hash, ADDR_CHECKSUM_SIZE);
+    oxen_keccak_256(&G_oxen_state.keccak, data, offset, checksum_hash);
+    memmove(data + offset, checksum_hash, ADDR_CHECKSUM_SIZE);
     offset += ADDR_CHECKSUM_SIZE;
 
     unsigned char full_block_count = offset / FULL_BLOCK_SIZE;
@@ -209,7 +234,8 @@ unsigned char oxen_wallet_address(char* str_b58,
 // str must be length >= 22
 void oxen_currency_str(uint64_t atomic_oxen, char* str) {
     // max uint64 is 18446744073709551616, aka 20 char, plus dot
-    unsigned char len, i, j;
+    unsigned char num[8];
+    unsigned char len, i, j, top;
     char tmp;
 
     // Special case short circuit for 0 OXEN
@@ -222,10 +248,12 @@ void oxen_currency_str(uint64_t atomic_oxen, char* str) {
     }
 
     // Write the value out in reverse; this is a bit easier since we don't know the length yet
-    for (len = 0; atomic_oxen; ++len) {
+    oxen_uint64_to_be(atomic_oxen, num);
+    for (len = 0, top = 0;; ++len) {
+        while (top < 8 && num[top] == 0) top++;  // skip the leading 0 bytes
+        if (top == 8) break;
         if (len == COIN_DECIMAL) str[len++] = '.';
-        str[len] = '0' + atomic_oxen % 10;
-        atomic_oxen /= 10;
+        str[len] = '0' + oxen_be_divmod(num + top, 8 - top, 10);
     }
     if (len <= COIN_DECIMAL) {
         // The value is less than 1 OXEN so add any needed significant 0's and add the '.0'
@@ -26,16 +26,53 @@
 /* ----------------------------------------------------------------------- */
 /* ---                                                                 --- */
 /* ----------------------------------------------------------------------- */
-void monero_reset_tx(int reset_tx_cnt) {
+// Resets what belongs to a single tx (keys, hash chains, counters); the session (hmac key, tx
+// count) is left alone so that a sub-tx can carry on with it.
+static void oxen_reset_tx_chains(void) {
+    // Before the transcript: the slots share its RAM
+    oxen_clsag_reset_slots();
     memset(G_oxen_state.r, 0, 32);
     memset(G_oxen_state.R, 0, 32);
-    cx_rng(G_oxen_state.hmac_key, 32);
+    memset(G_oxen_state.change_derivation, 0, 32);
+    memset(G_oxen_state.additional_key_seed, 0, 32);
+    cx_rng(G_oxen_state.alpha_key, 32);
 
     cx_keccak_init(&G_oxen_state.keccak_alt, 256);
-    cx_sha256_init(&G_oxen_state.sha256_alt);
-    cx_sha256_init(&G_oxen_state.sha256);
-    G_oxen_state.tx_in_progress = 0;
+    oxen_transcript_reset();
+    memset(G_oxen_state.prefixH, 0, 32);
+    G_oxen_state.tx_outputs_done = 0;
     G_oxen_state.tx_output_cnt = 0;
+    G_oxen_state.tx_additional_key_cnt = 0;
+    G_oxen_state.summary_total = 0;
+    G_oxen_state.summary_change = 0;
+    G_oxen_state.summary_dest_cnt = 0;
+    G_oxen_state.summary_multi_dest = 0;
+    memset(G_oxen_state.summary_dest, 0, 64);
+    G_oxen_state.policy_tx_total = 0;
+    G_oxen_state.tx_policy_miss = 0;
+    G_oxen_state.session_tx_total = 0;
+    G_oxen_state.tx_session_miss = 0;
+}
+
+void monero_reset_tx(int reset_tx_cnt) {
+    if (G_oxen_state.ux_pending) {
+        // The prompt on screen belongs to the tx going away
+        G_oxen_state.ux_pending = 0;
+        ui_menu_main_display();
+    }
+    G_oxen_state.ux_queued = 0;
+    // A proof session keeps its state where the transcript goes, so it ends here
+    if (G_oxen_state.tx_state_ins == INS_GET_TX_PROOF ||
+        G_oxen_state.tx_state_ins == INS_RESERVE_PROOF) {
+        clear_protocol();
+    }
+    oxen_reset_tx_chains();
+    oxen_drv_cache_wipe();
+    cx_rng(G_oxen_state.hmac_key, 32);
+    G_oxen_state.tx_session = 0;
+    G_oxen_state.session_left = 0;
+    memset(G_oxen_state.session_dest, 0, 32);
+    G_oxen_state.tx_in_progress = 0;
     if (reset_tx_cnt) {
         G_oxen_state.tx_cnt = 0;
     }
@@ -44,8 +81,18 @@ void monero_reset_tx(int reset_tx_cnt) {
 /* ----------------------------------------------------------------------- */
 /* ---                                                                 --- */
 /* ----------------------------------------------------------------------- */
+/*
+ * [OPEN_TX, 1, 0]: version(2) || type(2), big-endian.  A standard tx that opens a multi-tx session
+ * can append cap(8, big-endian) || is_subaddress(1) || A(32) || B(32): once the user confirms the
+ * cap and the recipient, outputs of the session's txes to that recipient skip their prompts for as
+ * long as their total stays within the cap.  A fake tx ignores the cap.
+ */
 int monero_apdu_open_tx(void) {
     uint16_t txversion, txtype;
+    uint64_t cap;
+    unsigned char is_subaddress;
+    unsigned char A[32];
+    unsigned char B[32];
 
     txversion = monero_io_fetch_u16();
     txtype = monero_io_fetch_u16();
@@ -55,29 +102,74 @@ int monero_apdu_open_tx(void) {
           txtype == TXTYPE_ONS))
         THROW(SW_WRONG_DATA_RANGE);
 
-    monero_io_discard(1);
-
     monero_reset_tx(0);
     G_oxen_state.tx_type = txtype;
     G_oxen_state.tx_cnt++;
-    ui_menu_opentx_display(0);
-    if (G_oxen_state.tx_sig_mode == TRANSACTION_CREATE_REAL) {
-        // return 0;
+
+    if (monero_io_fetch_available() && G_oxen_state.tx_sig_mode == TRANSACTION_CREATE_REAL) {
+        if (txtype != TXTYPE_STANDARD) THROW(SW_WRONG_DATA_RANGE);
+        cap = monero_io_fetch_u32();
+        cap = (cap << 32) | monero_io_fetch_u32();
+        is_subaddress = monero_io_fetch_u8();
+        monero_io_fetch(A, 32);
+        monero_io_fetch(B, 32);
+        monero_io_discard(1);
+
+        // Only enabled once confirmed
+        G_oxen_state.session_left = cap;
+        oxen_policy_dest_hash(G_oxen_state.session_dest, A, B);
+
+        oxen_currency_str(cap, G_oxen_state.ux_amount);
+        memset(G_oxen_state.ux_address, 0, sizeof(G_oxen_state.ux_address));
+        oxen_wallet_address(G_oxen_state.ux_address, A, B, is_subaddress, NULL);
+        ui_menu_session_display();
+        return 0;
     }
+    monero_io_discard(1);
+
+    ui_menu_opentx_display(0);
     return monero_apdu_open_tx_cont();
 }
 
-int monero_apdu_open_tx_cont(void) {
-    G_oxen_state.tx_in_progress = 1;
+// Called from the UI once the user accepted the session cap of [OPEN_TX, 1, 0]
+int oxen_session_confirmed(void) {
+    G_oxen_state.tx_session = 1;
+    return monero_apdu_open_tx_cont();
+}
 
-#ifdef DEBUG_HWDEVICE
-    memset(G_oxen_state.hmac_key, 0xab, 32);
-#else
-    cx_rng(G_oxen_state.hmac_key, 32);
-#endif
+// Whether a recipient output stays within the session cap.  What it sends is only taken off the cap
+// when the next sub-tx opens, i.e. once this one is signed.
+int oxen_session_allows_output(const unsigned char *Aout,
+                               const unsigned char *Bout,
+                               uint64_t amount) {
+    unsigned char hash[32];
+    uint64_t total = G_oxen_state.session_tx_total + amount;
+
+    if (G_oxen_state.tx_session && total >= amount && total <= G_oxen_state.session_left) {
+        oxen_policy_dest_hash(hash, Aout, Bout);
+        if (memcmp(hash, G_oxen_state.session_dest, 32) == 0) {
+            G_oxen_state.session_tx_total = total;
+            return 1;
+        }
+    }
+    G_oxen_state.tx_session_miss = 1;
+    return 0;
+}
 
+static int oxen_open_tx_keys(void) {
     monero_rng_mod_order(G_oxen_state.r);
-    monero_ecmul_G(G_oxen_state.R, G_oxen_state.r);
+    if (OXEN_TX_FAKE_MODE()) {
+        // Any valid point will do for a fake tx
+        memmove(G_oxen_state.R, G_oxen_state.view_pub, 32);
+    } else {
+        monero_ecmul_G(G_oxen_state.R, G_oxen_state.r);
+        // Every change output (and a payment id encrypted to ourselves) derives with 8.a.R, so do
+        // it once here rather than once per output.
+        monero_generate_key_derivation(G_oxen_state.change_derivation,
+                                       G_oxen_state.R,
+                                       G_oxen_state.view_priv);
+    }
+    cx_rng(G_oxen_state.additional_key_seed, 32);
 
     monero_io_insert(G_oxen_state.R, 32);
     monero_io_insert_encrypt(G_oxen_state.r, 32, TYPE_SCALAR);
@@ -88,6 +180,48 @@ int monero_apdu_open_tx_cont(void) {
     return SW_OK;
 }
 
+int monero_apdu_open_tx_cont(void) {
+    G_oxen_state.tx_in_progress = 1;
+
+#ifdef DEBUG_HWDEVICE
+    memset(G_oxen_state.hmac_key, 0xab, 32);
+#else
+    cx_rng(G_oxen_state.hmac_key, 32);
+#endif
+
+    return oxen_open_tx_keys();
+}
+
+/* ----------------------------------------------------------------------- */
+/* ---                                                                 --- */
+/* ----------------------------------------------------------------------- */
+/*
+ * Starts the next tx of a session once the current one is fully signed: the hmac key is kept, so
+ * values the device encrypted for the session (e.g. input derivations and secret keys) stay valid,
+ * while R/r, the alpha key, the prefix hash and the integrity transcript start over.  Each sub-tx
+ * goes through its own confirmations, except for the outputs within the session cap (see
+ * monero_apdu_open_tx).
+ */
+int monero_apdu_open_subtx(void) {
+    uint16_t txversion, txtype;
+
+    txversion = monero_io_fetch_u16();
+    txtype = monero_io_fetch_u16();
+
+    if (txversion != 4) THROW(SW_WRONG_DATA_RANGE);
+    // A session is made of txes of one type
+    if (txtype != G_oxen_state.tx_type) THROW(SW_WRONG_DATA_RANGE);
+
+    monero_io_discard(1);
+
+    // The previous tx is signed: what it sent within the cap is spent
+    G_oxen_state.session_left -= G_oxen_state.session_tx_total;
+    oxen_reset_tx_chains();
+    G_oxen_state.tx_cnt++;
+    ui_menu_opentx_display(0);
+    return oxen_open_tx_keys();
+}
+
 /* ----------------------------------------------------------------------- */
 /* ---                                                                 --- */
 /* ----------------------------------------------------------------------- */
@@ -0,0 +1,222 @@
+/*****************************************************************************
+ *   Ledger Oxen App.
+ *   (c) 2020 Oxen Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *****************************************************************************/
+
+/*
+ * Unattended signing policy.
+ *
+ * The policy lives in NVRAM and can only be changed with an on-screen confirmation.  When it is
+ * enabled and covers the type of a tx, the prompts that the tx fully satisfies are skipped: the fee
+ * when under the fee cap, each recipient output when the recipient is allow-listed and both the
+ * per-tx cap and the remaining budget allow for it, change back to the main address or to a
+ * subaddress of the table, stake amounts, and the unlock/ONS confirmations.  Anything outside of
+ * the policy (and any timelock) is still prompted for.
+ */
+
+#include "os.h"
+#include "cx.h"
+#include "oxen_types.h"
+#include "oxen_api.h"
+#include "oxen_vars.h"
+
+/* ----------------------------------------------------------------------- */
+/* ---                                                                 --- */
+/* ----------------------------------------------------------------------- */
+int oxen_policy_covers(unsigned char txtype) {
+    return N_oxen_state->policy.enabled && (N_oxen_state->policy.tx_types & (1 << txtype));
+}
+
+int oxen_policy_allows_fee(uint64_t fee) {
+    return G_oxen_state.tx_sig_mode == TRANSACTION_CREATE_REAL &&
+           oxen_policy_covers(G_oxen_state.tx_type) && fee <= N_oxen_state->policy.max_fee;
+}
+
+void oxen_policy_dest_hash(unsigned char *hash,
+                           const unsigned char *Aout,
+                           const unsigned char *Bout) {
+    unsigned char AB[64];
+    memmove(AB, Aout, 32);
+    memmove(AB + 32, Bout, 32);
+    oxen_keccak_256(&G_oxen_state.keccak, AB, 64, hash);
+}
+
+static int oxen_policy_find_dest(const unsigned char *hash) {
+    for (unsigned int i = 0; i < N_oxen_state->policy.dest_cnt; i++) {
+        if (memcmp((void *) N_oxen_state->policy.dests[i], hash, 32) == 0) return 1;
+    }
+    return 0;
+}
+
+// What is left of the budget: NVRAM spent already includes the reserved part
+static uint64_t oxen_policy_left(void) {
+    return N_oxen_state->policy.budget - N_oxen_state->policy.spent + G_oxen_state.policy_reserved;
+}
+
+int oxen_policy_allows_output(const unsigned char *Aout,
+                              const unsigned char *Bout,
+                              uint64_t amount) {
+    unsigned char hash[32];
+    uint64_t total = G_oxen_state.policy_tx_total + amount;
+
+    if (G_oxen_state.tx_sig_mode == TRANSACTION_CREATE_REAL &&
+        oxen_policy_covers(G_oxen_state.tx_type) && total >= amount &&
+        total <= N_oxen_state->policy.max_tx_amount && total <= oxen_policy_left()) {
+        oxen_policy_dest_hash(hash, Aout, Bout);
+        if (oxen_policy_find_dest(hash)) {
+            G_oxen_state.policy_tx_total = total;
+            return 1;
+        }
+    }
+    G_oxen_state.tx_policy_miss = 1;
+    return 0;
+}
+
+// Charges what the policy approved for this tx to the budget, once all of its outputs are in and
+// every prompt of the tx was accepted (see oxen_prehash.c): a rejected tx isn't charged.
+//
+// policy.spent is in flash, so it isn't written for each tx: a write charges the tx plus up to
+// budget / POLICY_RESERVE_PARTS more, which the next covered txes then use from RAM.  Losing the
+// reserve (lock, app exit, new policy) only loses budget, never gives more, and a budget takes at
+// most about POLICY_RESERVE_PARTS writes plus one per tx larger than the reserve.
+void oxen_policy_charge_tx(void) {
+    uint64_t total = G_oxen_state.policy_tx_total;
+    uint64_t spent, reserve, left;
+
+    if (total == 0) return;
+    G_oxen_state.policy_tx_total = 0;
+    if (total <= G_oxen_state.policy_reserved) {
+        G_oxen_state.policy_reserved -= total;
+        return;
+    }
+
+    // allows_output() checked total against oxen_policy_left(), so this can't overflow the budget
+    spent = N_oxen_state->policy.spent + total - G_oxen_state.policy_reserved;
+    left = N_oxen_state->policy.budget - spent;
+    reserve = N_oxen_state->policy.budget / POLICY_RESERVE_PARTS;
+    if (reserve > left) reserve = left;
+    spent += reserve;
+    nvm_write((void *) &N_oxen_state->policy.spent, &spent, sizeof(spent));
+    G_oxen_state.policy_reserved = reserve;
+}
+
+/* ----------------------------------------------------------------------- */
+/* ---                           SET POLICY                            --- */
+/* ----------------------------------------------------------------------- */
+static uint64_t oxen_policy_fetch_u64(void) {
+    uint64_t v = monero_io_fetch_u32();
+    return (v << 32) | monero_io_fetch_u32();
+}
+
+static void oxen_policy_types_str(unsigned char tx_types, char *str) {
+    // Indexed by TXTYPE_*; state changes are never made by a wallet
+    static const char names[][4] = {"Std", "", "Unl", "Stk", "ONS"};
+    unsigned char len = 0;
+
+    for (unsigned int i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (!names[i][0] || !(tx_types & (1 << i))) continue;
+        if (len) str[len++] = ' ';
+        memmove(str + len, names[i], 3);
+        len += 3;
+    }
+    if (!len) {
+        memmove(str, "None", 4);
+        len = 4;
+    }
+    str[len] = 0;
+}
+
+/*
+ * [SET_POLICY, 0, 0]: clears the policy (no confirmation needed: this only brings prompts back).
+ * [SET_POLICY, 1, 0]: tx_types(1) || max_tx_amount(8) || max_fee(8) || budget(8), big-endian;
+ *     enables the policy with these caps and a fresh budget.
+ * [SET_POLICY, 2, 0]: is_subaddress(1) || A(32) || B(32); adds the recipient to the allow list.
+ */
+int oxen_apdu_set_policy(void) {
+    unsigned char *pending = G_oxen_state.policy_pending;
+    unsigned char is_subaddress;
+    unsigned char A[32];
+    unsigned char B[32];
+    uint64_t max_tx_amount, max_fee, budget;
+
+    switch (G_oxen_state.io_p1) {
+        case 0:
+            monero_io_discard(1);
+            nvm_write((void *) &N_oxen_state->policy, NULL, sizeof(oxen_policy_t));
+            G_oxen_state.policy_reserved = 0;
+            return SW_OK;
+
+        case 1:
+            pending[0] = monero_io_fetch_u8();
+            max_tx_amount = oxen_policy_fetch_u64();
+            max_fee = oxen_policy_fetch_u64();
+            budget = oxen_policy_fetch_u64();
+            monero_io_discard(1);
+            memmove(pending + 1, &max_tx_amount, 8);
+            memmove(pending + 9, &max_fee, 8);
+            memmove(pending + 17, &budget, 8);
+
+            memset(G_oxen_state.ux_addr_type, 0, sizeof(G_oxen_state.ux_addr_type));
+            oxen_policy_types_str(pending[0], G_oxen_state.ux_addr_type);
+            oxen_currency_str(max_tx_amount, G_oxen_state.ux_amount);
+            oxen_currency_str(max_fee, G_oxen_state.ux_addr_info);
+            oxen_currency_str(budget, G_oxen_state.ux_address);
+            ui_menu_policy_caps_display();
+            return 0;
+
+        case 2:
+            is_subaddress = monero_io_fetch_u8();
+            monero_io_fetch(A, 32);
+            monero_io_fetch(B, 32);
+            monero_io_discard(1);
+
+            oxen_policy_dest_hash(pending, A, B);
+            if (oxen_policy_find_dest(pending)) return SW_OK;
+            if (N_oxen_state->policy.dest_cnt >= POLICY_MAX_DESTS) THROW(SW_WRONG_DATA_RANGE);
+
+            memset(G_oxen_state.ux_address, 0, sizeof(G_oxen_state.ux_address));
+            oxen_wallet_address(G_oxen_state.ux_address, A, B, is_subaddress, NULL);
+            ui_menu_policy_dest_display();
+            return 0;
+
+        default:
+            THROW(SW_WRONG_P1P2);
+    }
+    return SW_OK;
+}
+
+// Called from the UI once the user accepted the [SET_POLICY, 1/2] data in policy_pending
+void oxen_policy_confirmed(void) {
+    unsigned char *pending = G_oxen_state.policy_pending;
+    unsigned char c;
+    uint64_t spent = 0;
+
+    if (G_oxen_state.io_p1 == 1) {
+        nvm_write((void *) &N_oxen_state->policy.tx_types, pending, 1);
+        nvm_write((void *) &N_oxen_state->policy.max_tx_amount, pending + 1, 8);
+        nvm_write((void *) &N_oxen_state->policy.max_fee, pending + 9, 8);
+        nvm_write((void *) &N_oxen_state->policy.budget, pending + 17, 8);
+        nvm_write((void *) &N_oxen_state->policy.spent, &spent, 8);
+        G_oxen_state.policy_reserved = 0;
+        c = 1;
+        nvm_write((void *) &N_oxen_state->policy.enabled, &c, 1);
+    } else {
+        c = N_oxen_state->policy.dest_cnt;
+        nvm_write((void *) N_oxen_state->policy.dests[c], pending, 32);
+        c++;
+        nvm_write((void *) &N_oxen_state->policy.dest_cnt, &c, 1);
+    }
+    memset(pending, 0, 32);
+}
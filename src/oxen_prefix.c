@@ -32,17 +32,20 @@
 /* ----------------------------------------------------------------------- */
 // str must be size >= 21
 static void monero_uint642str(uint64_t val, char *str) {
-    unsigned char len, i, j;
+    unsigned char num[8];
+    unsigned char len, i, j, top;
     char tmp;
 
     len = 0;
+    top = 0;
+    oxen_uint64_to_be(val, num);
 
     // Write it out in reverse, then swap it (because until we write it out we won't know the
     // length)
     do {
-        str[len++] = '0' + val % 10;
-        val /= 10;
-    } while (val);
+        str[len++] = '0' + oxen_be_divmod(num + top, 8 - top, 10);
+        while (top < 8 && num[top] == 0) top++;
+    } while (top < 8);
 
     // Reverse it
     for (i = 0, j = len - 1; i < j; ++i, --j) {
@@ -27,15 +27,167 @@
 #include "oxen_api.h"
 #include "oxen_vars.h"
 
+/* ----------------------------------------------------------------------- */
+/* ---                          PROMPT PIPELINE                        --- */
+/* ----------------------------------------------------------------------- */
+/*
+ * A VALIDATE command that needs a confirmation shows it and is answered straight away, so that the
+ * host can send the next command while the user reads the screen.  That next command is processed
+ * (commitment check, hash chains) but its reply is held until the user answers the prompt; then its
+ * own prompt, if any, is shown and it is answered in turn.  The finalize step is held the same way,
+ * so nothing gets signed before every prompt is accepted.  A rejection is reported as SW_DENY on
+ * the held command, or on the next one if there is none yet.
+ *
+ * Prompts only get formatted into the ux buffers when shown, from the prompt_* data.  So the
+ * address of a held output is base58-encoded once the previous prompt is answered, not while that
+ * one is still on screen: encoding it ahead would take a second 109 byte ux_address, which the
+ * Nano S can't spare.
+ *
+ * The transcript and the summary take a held output in right away, but the policy budget is only
+ * charged once every prompt of the tx was accepted (oxen_prehash_settled()), so a rejected tx costs
+ * nothing.
+ */
+#define PREHASH_PROMPT_NONE    0
+#define PREHASH_PROMPT_FEE     1
+#define PREHASH_PROMPT_ONS_FEE 2
+#define PREHASH_PROMPT_OUTPUT  3
+#define PREHASH_PROMPT_STAKE   4
+#define PREHASH_PROMPT_CHANGE  5
+#define PREHASH_PROMPT_SUMMARY 6
+
+static void oxen_format_dest_address(const unsigned char *A,
+                                     const unsigned char *B,
+                                     unsigned char is_subaddress) {
+    unsigned char pos = oxen_wallet_address(G_oxen_state.ux_address,
+                                            (unsigned char *) A,
+                                            (unsigned char *) B,
+                                            is_subaddress,
+                                            NULL);
+    if (N_oxen_state->truncate_addrs_mode == CONFIRM_ADDRESS_SHORT) {
+        // First 23, "..", last 23 (so total is 48 = 3 pages on Nano S)
+        G_oxen_state.ux_address[23] = '.';
+        G_oxen_state.ux_address[24] = '.';
+        memmove(&G_oxen_state.ux_address[25], &G_oxen_state.ux_address[pos - 23], 23);
+        pos = 48;
+    } else if (N_oxen_state->truncate_addrs_mode == CONFIRM_ADDRESS_SHORTER) {
+        // 16..14 so that first page gets first [16], last page gets last [..14]
+        G_oxen_state.ux_address[16] = '.';
+        G_oxen_state.ux_address[17] = '.';
+        memmove(&G_oxen_state.ux_address[18], &G_oxen_state.ux_address[pos - 14], 14);
+        pos = 32;
+    }
+    G_oxen_state.ux_address[pos] = 0;  // null terminate
+}
+
+static void oxen_summary_display(void) {
+    if (G_oxen_state.summary_dest_cnt == 0) {
+        memmove(G_oxen_state.ux_address, "None", 5);
+    } else if (G_oxen_state.summary_multi_dest) {
+        memmove(G_oxen_state.ux_address, "Multiple recipients", 20);
+    } else {
+        oxen_format_dest_address(G_oxen_state.summary_dest,
+                                 G_oxen_state.summary_dest + 32,
+                                 G_oxen_state.summary_dest_is_subaddress);
+    }
+
+    snprintf(G_oxen_state.ux_addr_type,
+             sizeof(G_oxen_state.ux_addr_type),
+             G_oxen_state.summary_dest_cnt == 1 ? "%d output" : "%d outputs",
+             G_oxen_state.summary_dest_cnt);
+    oxen_currency_str(G_oxen_state.summary_total, G_oxen_state.ux_amount);
+    oxen_currency_str(G_oxen_state.summary_change, G_oxen_state.ux_addr_info);
+    ui_menu_summary_validation_display();
+}
+
+// Charges the tx to the policy budget once all its outputs are in with no prompt left on screen
+static void oxen_prehash_settled(void) {
+    if (G_oxen_state.tx_outputs_done && !G_oxen_state.ux_pending) {
+        oxen_policy_charge_tx();
+    }
+}
+
+static void oxen_prehash_show(void) {
+    switch (G_oxen_state.prompt_screen) {
+        case PREHASH_PROMPT_FEE:
+            oxen_currency_str(G_oxen_state.prompt_amount, G_oxen_state.ux_amount);
+            ui_menu_fee_validation_display();
+            break;
+        case PREHASH_PROMPT_ONS_FEE:
+            oxen_currency_str(G_oxen_state.prompt_amount, G_oxen_state.ux_amount);
+            ui_menu_lns_fee_validation_display();
+            break;
+        case PREHASH_PROMPT_OUTPUT:
+            oxen_currency_str(G_oxen_state.prompt_amount, G_oxen_state.ux_amount);
+            oxen_format_dest_address(G_oxen_state.prompt_A,
+                                     G_oxen_state.prompt_B,
+                                     G_oxen_state.prompt_is_subaddress);
+            ui_menu_validation_display();
+            break;
+        case PREHASH_PROMPT_STAKE:
+            oxen_currency_str(G_oxen_state.prompt_amount, G_oxen_state.ux_amount);
+            ui_menu_stake_validation_display();
+            break;
+        case PREHASH_PROMPT_CHANGE:
+            oxen_currency_str(G_oxen_state.prompt_amount, G_oxen_state.ux_amount);
+            ui_menu_change_validation_display();
+            break;
+        case PREHASH_PROMPT_SUMMARY:
+            oxen_summary_display();
+            break;
+        default:
+            oxen_prehash_settled();
+            return;
+    }
+    G_oxen_state.ux_pending = 1;
+}
+
+// Returns the status of the current command: SW_OK once its prompt (if any) is shown, or 0 to hold
+// it while the previous prompt is still on screen.
+static int oxen_prehash_prompt(unsigned char screen) {
+    G_oxen_state.prompt_screen = screen;
+    if (G_oxen_state.ux_pending) {
+        G_oxen_state.ux_queued = 1;
+        return 0;
+    }
+    oxen_prehash_show();
+    return SW_OK;
+}
+
+// Called from the UI with the user's answer to the prompt on screen
+void oxen_prehash_prompt_answered(unsigned int accepted) {
+    unsigned char queued = G_oxen_state.ux_queued;
+
+    G_oxen_state.ux_pending = 0;
+    if (!accepted) {
+        monero_abort_tx();
+        if (queued) {
+            monero_io_discard(0);
+            monero_io_insert_u16(SW_DENY);
+            monero_io_do(IO_RETURN_AFTER_TX);
+        } else {
+            G_oxen_state.ux_deny_pending = 1;
+        }
+        return;
+    }
+
+    ui_menu_opentx_display(1);
+    if (queued) {
+        G_oxen_state.ux_queued = 0;
+        oxen_prehash_show();
+        monero_io_insert_u16(SW_OK);
+        monero_io_do(IO_RETURN_AFTER_TX);
+    } else {
+        oxen_prehash_settled();
+    }
+}
+
 /* ----------------------------------------------------------------------- */
 /* ---                                                                 --- */
 /* ----------------------------------------------------------------------- */
 int monero_apdu_clsag_prehash_init(void) {
     if (G_oxen_state.tx_sig_mode == TRANSACTION_CREATE_REAL) {
         if (G_oxen_state.io_p2 == 1) {
-            oxen_hash_final(&G_oxen_state.sha256, G_oxen_state.OUTK);
-            cx_sha256_init(&G_oxen_state.sha256);
-            cx_sha256_init(&G_oxen_state.sha256_alt);
+            oxen_transcript_snapshot(TRANSCRIPT_OUTPUTS);
             cx_keccak_init(&G_oxen_state.keccak_alt, 256);
         }
     }
@@ -68,14 +220,12 @@ int monero_apdu_clsag_prehash_init(void) {
             default:
                 break;
         }
+        if (amount > 0 && oxen_policy_allows_fee(amount)) amount = 0;
         if (amount > 0) {
             // ask user
-            oxen_currency_str(amount, G_oxen_state.ux_amount);
-            if (G_oxen_state.tx_type == TXTYPE_ONS)
-                ui_menu_lns_fee_validation_display();
-            else
-                ui_menu_fee_validation_display();
-            return 0;
+            G_oxen_state.prompt_amount = amount;
+            return oxen_prehash_prompt(G_oxen_state.tx_type == TXTYPE_ONS ? PREHASH_PROMPT_ONS_FEE
+                                                                         : PREHASH_PROMPT_FEE);
         }
         return SW_OK;
     } else {
@@ -84,6 +234,54 @@ int monero_apdu_clsag_prehash_init(void) {
     }
 }
 
+/* ----------------------------------------------------------------------- */
+/* ---                                                                 --- */
+/* ----------------------------------------------------------------------- */
+static void oxen_summary_add_output(const unsigned char *Aout,
+                                    const unsigned char *Bout,
+                                    unsigned char is_subaddress,
+                                    unsigned char is_change,
+                                    uint64_t amount) {
+    uint64_t *sum = is_change ? &G_oxen_state.summary_change : &G_oxen_state.summary_total;
+    if (*sum + amount < *sum) {
+        monero_lock_and_throw(SW_WRONG_DATA_RANGE);
+    }
+    *sum += amount;
+    if (is_change) {
+        return;
+    }
+
+    if (G_oxen_state.summary_dest_cnt == 255) {
+        monero_lock_and_throw(SW_SECURITY_MAXOUTPUT_REACHED);
+    }
+    if (G_oxen_state.summary_dest_cnt++ == 0) {
+        memmove(G_oxen_state.summary_dest, Aout, 32);
+        memmove(G_oxen_state.summary_dest + 32, Bout, 32);
+        G_oxen_state.summary_dest_is_subaddress = is_subaddress;
+    } else if (memcmp(G_oxen_state.summary_dest, Aout, 32) ||
+               memcmp(G_oxen_state.summary_dest + 32, Bout, 32)) {
+        G_oxen_state.summary_multi_dest = 1;
+    }
+}
+
+// Whether the summary has nothing the user did not approve beforehand: every output is covered by
+// the policy, or every recipient output is within the session cap and there is no change to confirm
+static int oxen_summary_approved(void) {
+    if (oxen_policy_covers(G_oxen_state.tx_type) && !G_oxen_state.tx_policy_miss) return 1;
+    return G_oxen_state.tx_session && !G_oxen_state.tx_session_miss &&
+           G_oxen_state.summary_dest_cnt &&
+           (G_oxen_state.summary_change == 0 ||
+            N_oxen_state->confirm_change_mode == CONFIRM_CHANGE_DISABLED);
+}
+
+// Whether (Aout, Bout) is the main address or one of the subaddresses of the table
+static int oxen_is_own_address(const unsigned char *Aout, const unsigned char *Bout) {
+    if (memcmp(Aout, G_oxen_state.view_pub, 32) == 0 &&
+        memcmp(Bout, G_oxen_state.spend_pub, 32) == 0)
+        return 1;
+    return oxen_subaddr_table_find(Aout, Bout);
+}
+
 /* ----------------------------------------------------------------------- */
 /* ---                                                                 --- */
 /* ----------------------------------------------------------------------- */
@@ -122,31 +320,16 @@ int monero_apdu_clsag_prehash_update(void) {
     }
 
     if (G_oxen_state.tx_sig_mode == TRANSACTION_CREATE_REAL) {
-        if (!is_change && G_oxen_state.tx_type != TXTYPE_STAKE &&
-            G_oxen_state.tx_type != TXTYPE_ONS) {
-            // encode dest adress
-            unsigned char pos =
-                oxen_wallet_address(G_oxen_state.ux_address, Aout, Bout, is_subaddress, NULL);
-            if (N_oxen_state->truncate_addrs_mode == CONFIRM_ADDRESS_SHORT) {
-                // First 23, "..", last 23 (so total is 48 = 3 pages on Nano S)
-                G_oxen_state.ux_address[23] = '.';
-                G_oxen_state.ux_address[24] = '.';
-                memmove(&G_oxen_state.ux_address[25], &G_oxen_state.ux_address[pos - 23], 23);
-                pos = 48;
-            } else if (N_oxen_state->truncate_addrs_mode == CONFIRM_ADDRESS_SHORTER) {
-                // 16..14 so that first page gets first [16], last page gets last [..14]
-                G_oxen_state.ux_address[16] = '.';
-                G_oxen_state.ux_address[17] = '.';
-                memmove(&G_oxen_state.ux_address[18], &G_oxen_state.ux_address[pos - 14], 14);
-                pos = 32;
-            }
-            G_oxen_state.ux_address[pos] = 0;  // null terminate
+        // Nothing can follow the last output: it would escape the summary confirmation
+        if (G_oxen_state.tx_outputs_done) {
+            monero_lock_and_throw(SW_SECURITY_OUTKEYS_CHAIN_CONTROL);
         }
-        // update destination hash control
-        oxen_hash_update(&G_oxen_state.sha256, Aout, 32);
-        oxen_hash_update(&G_oxen_state.sha256, Bout, 32);
-        oxen_hash_update(&G_oxen_state.sha256, &is_change, 1);
-        oxen_hash_update(&G_oxen_state.sha256, aH, 32);
+        unsigned char summary = G_oxen_state.tx_type == TXTYPE_STANDARD &&
+                                N_oxen_state->confirm_outputs_mode == CONFIRM_OUTPUTS_SUMMARY;
+        unsigned char screen = PREHASH_PROMPT_NONE;
+
+        // update destination transcript
+        oxen_transcript_absorb_output(Aout, Bout, is_change, aH);
 
         // check C = aH+kG
         monero_unblind(v, k, aH, G_oxen_state.options & 0x03);
@@ -160,25 +343,39 @@ int monero_apdu_clsag_prehash_update(void) {
         if (memcmp(C, aH, 32)) {
             monero_lock_and_throw(SW_SECURITY_COMMITMENT_CONTROL);
         }
-        // update commitment hash control
-        oxen_hash_update(&G_oxen_state.sha256_alt, C, 32);
+        // update commitment transcript
+        oxen_transcript_absorb(TRANSCRIPT_COMMITMENTS, C, 32);
 
         if ((G_oxen_state.options & IN_OPTION_MORE_COMMAND) == 0) {
-            // finalize and check destination hash_control
-            oxen_hash_final(&G_oxen_state.sha256, k);
-            if (memcmp(k, G_oxen_state.OUTK, 32)) {
-                monero_lock_and_throw(SW_SECURITY_OUTKEYS_CHAIN_CONTROL);
-            }
-            // finalize commitment hash control
-            oxen_hash_final(&G_oxen_state.sha256_alt, G_oxen_state.commitment_hash);
-            cx_sha256_init(&G_oxen_state.sha256_alt);
+            // check the destinations against the ones of the output keys
+            oxen_transcript_check(TRANSCRIPT_OUTPUTS, SW_SECURITY_OUTKEYS_CHAIN_CONTROL);
+            // keep the commitments for the finalization to check
+            oxen_transcript_snapshot(TRANSCRIPT_COMMITMENTS);
+            G_oxen_state.tx_outputs_done = 1;
         }
 
         // ask user
         uint64_t amount;
         amount = monero_bamount2uint64(v);
-        if (amount) {
-            oxen_currency_str(amount, G_oxen_state.ux_amount);
+        // The policy only skips the change prompt for change that provably comes back to us:
+        // anything else is shown, and checked, as an output to someone else
+        unsigned char foreign_change = is_change && amount &&
+                                       oxen_policy_covers(G_oxen_state.tx_type) &&
+                                       !oxen_is_own_address(Aout, Bout);
+        unsigned char approved = 0;
+        if (foreign_change) {
+            G_oxen_state.tx_policy_miss = 1;
+            is_change = 0;
+        } else if (amount && !is_change && G_oxen_state.tx_type == TXTYPE_STANDARD) {
+            approved = oxen_policy_allows_output(Aout, Bout, amount) ||
+                       oxen_session_allows_output(Aout, Bout, amount);
+        }
+        if (summary) {
+            oxen_summary_add_output(Aout, Bout, is_subaddress, is_change, amount);
+            // Once all outputs are in and the transcript checked out: show the totals
+            if (G_oxen_state.tx_outputs_done && !oxen_summary_approved())
+                screen = PREHASH_PROMPT_SUMMARY;
+        } else if (amount) {
             if (!is_change) {
                 if (G_oxen_state.tx_type == TXTYPE_STAKE || G_oxen_state.tx_type == TXTYPE_ONS) {
                     // If this is a stake or ONS tx then the non-change recipient must be ourself.
@@ -186,15 +383,20 @@ int monero_apdu_clsag_prehash_update(void) {
                         memcmp(Bout, G_oxen_state.spend_pub, 32))
                         monero_lock_and_throw(SW_SECURITY_INTERNAL);
 
-                    ui_menu_stake_validation_display();
-                } else
-                    ui_menu_validation_display();
-            } else if (N_oxen_state->confirm_change_mode == CONFIRM_CHANGE_DISABLED)
-                return SW_OK;
-            else
-                ui_menu_change_validation_display();
-            return 0;
+                    if (!oxen_policy_covers(G_oxen_state.tx_type)) screen = PREHASH_PROMPT_STAKE;
+                } else if (!approved) {
+                    memmove(G_oxen_state.prompt_A, Aout, 32);
+                    memmove(G_oxen_state.prompt_B, Bout, 32);
+                    G_oxen_state.prompt_is_subaddress = is_subaddress;
+                    screen = PREHASH_PROMPT_OUTPUT;
+                }
+            } else if (N_oxen_state->confirm_change_mode != CONFIRM_CHANGE_DISABLED &&
+                       !oxen_policy_covers(G_oxen_state.tx_type)) {
+                screen = PREHASH_PROMPT_CHANGE;
+            }
+            G_oxen_state.prompt_amount = amount;
         }
+        return oxen_prehash_prompt(screen);
     }
     return SW_OK;
 }
@@ -212,14 +414,13 @@ int monero_apdu_clsag_prehash_finalize(void) {
         monero_io_fetch(H, 32);
         monero_io_discard(1);
         oxen_hash_update(&G_oxen_state.keccak_alt, H, 32);
-        oxen_hash_update(&G_oxen_state.sha256_alt, H, 32);
+        if (G_oxen_state.tx_sig_mode == TRANSACTION_CREATE_REAL) {
+            oxen_transcript_absorb(TRANSCRIPT_COMMITMENTS, H, 32);
+        }
     } else {
-        // Finalize and check commitment hash control
+        // Check the commitments against the ones of the prehash
         if (G_oxen_state.tx_sig_mode == TRANSACTION_CREATE_REAL) {
-            oxen_hash_final(&G_oxen_state.sha256_alt, H);
-            if (memcmp(H, G_oxen_state.commitment_hash, 32)) {
-                monero_lock_and_throw(SW_SECURITY_COMMITMENT_CHAIN_CONTROL);
-            }
+            oxen_transcript_check(TRANSCRIPT_COMMITMENTS, SW_SECURITY_COMMITMENT_CHAIN_CONTROL);
         }
         // compute last H
         oxen_hash_final(&G_oxen_state.keccak_alt, H);
@@ -237,6 +438,8 @@ int monero_apdu_clsag_prehash_finalize(void) {
         oxen_hash_final(&G_oxen_state.keccak_alt, H);
 
         monero_io_insert(H, 32);
+        // Hold the result back until every output prompt has been accepted
+        return oxen_prehash_prompt(PREHASH_PROMPT_NONE);
     }
 
     return SW_OK;
@@ -23,6 +23,95 @@
 #include "oxen_api.h"
 #include "oxen_vars.h"
 
+/* ----------------------------------------------------------------------- */
+/* ---                                                                 --- */
+/* ----------------------------------------------------------------------- */
+static void oxen_proof_decompress(unsigned char *Pxy, const unsigned char *P) {
+    Pxy[0] = 0x02;
+    memmove(&Pxy[1], P, 32);
+    cx_edwards_decompress_point(CX_CURVE_Ed25519, Pxy, 65);
+}
+
+// keccak("TXPROOF_V2"), the V2 proof domain separator
+static const unsigned char TXPROOF_V2_SEP[32] = {
+    0x23, 0x69, 0x2b, 0x68, 0xdb, 0xec, 0x0a, 0x2e, 0x32, 0x83, 0x40, 0x96, 0xeb, 0xbd, 0x28, 0x65,
+    0xe4, 0x7a, 0xf7, 0xb4, 0x67, 0x10, 0x7f, 0x0c, 0x65, 0x96, 0x81, 0x95, 0x41, 0xc9, 0x12, 0x13};
+
+// Hashes a decompressed point as its 32-byte compressed form (zeros when there is none)
+static void oxen_proof_hash_point(const unsigned char *Pxy) {
+    unsigned int mark = oxen_scratch_mark();
+    unsigned char *P = oxen_scratch_alloc(65);
+
+    if (Pxy) {
+        memmove(P, Pxy, 65);
+        cx_edwards_compress_point(CX_CURVE_Ed25519, P, 65);
+    } else {
+        memset(P, 0, 65);
+    }
+    oxen_hash_update(&G_oxen_state.keccak, &P[1], 32);
+    oxen_scratch_release(mark);
+}
+
+/*
+ * Signs (msg, D) with r, as [c, r]: X = kB (with Bxy) or kG (Bxy NULL), Y = kA, and
+ *   V1 (R NULL): c = H_n(msg || D || X || Y)
+ *   V2:          c = H_n(msg || D || X || Y || keccak("TXPROOF_V2") || R || A || B or 0)
+ * The hash is fed piece by piece as the points get computed, so nothing needs to be concatenated.
+ */
+static void oxen_tx_proof_sign(unsigned char *sig_c,
+                               unsigned char *sig_r,
+                               const unsigned char *msg,
+                               const unsigned char *R,
+                               const unsigned char *D,
+                               const unsigned char *Axy,
+                               const unsigned char *Bxy,
+                               const unsigned char *r) {
+    unsigned char k[32];
+    unsigned char XY[32];
+
+    // Generate random k
+    monero_rng_mod_order(k);
+
+    // H(msg || D
+    cx_keccak_init(&G_oxen_state.keccak, 256);
+    oxen_hash_update(&G_oxen_state.keccak, msg, 32);
+    oxen_hash_update(&G_oxen_state.keccak, D, 32);
+
+    if (Bxy) {
+        // X = kB
+        monero_ecmul_k_xy(XY, Bxy, k);
+    } else {
+        // X = kG
+        monero_ecmul_G(XY, k);
+    }
+    // || X
+    oxen_hash_update(&G_oxen_state.keccak, XY, 32);
+
+    // Y = kA
+    monero_ecmul_k_xy(XY, Axy, k);
+    // || Y
+    oxen_hash_update(&G_oxen_state.keccak, XY, 32);
+
+    if (R) {
+        // || sep || R || A || B or [0]
+        oxen_hash_update(&G_oxen_state.keccak, TXPROOF_V2_SEP, 32);
+        oxen_hash_update(&G_oxen_state.keccak, R, 32);
+        oxen_proof_hash_point(Axy);
+        oxen_proof_hash_point(Bxy);
+    }
+
+    // sig_c = H_n(...)
+    oxen_hash_final(&G_oxen_state.keccak, sig_c);
+    monero_reduce(sig_c);
+
+    // sig_c*r
+    monero_multm(XY, sig_c, r);
+    // sig_r = k - sig_c*r
+    monero_subm(sig_r, k, XY);
+
+    memset(k, 0, 32);
+}
+
 /* ----------------------------------------------------------------------- */
 /* ---                                                                 --- */
 /* ----------------------------------------------------------------------- */
@@ -33,10 +122,11 @@ int monero_apdu_get_tx_proof(void) {
     unsigned char *B;
     unsigned char *D;
     unsigned char r[32];
-    unsigned char XY[32];
     unsigned char sig_c[32];
     unsigned char sig_r[32];
-#define k (G_oxen_state.tmp + 128)  // We go 32 bytes into this
+    unsigned int mark = oxen_scratch_mark();
+    unsigned char *Axy = oxen_scratch_alloc(65);
+    unsigned char *Bxy = oxen_scratch_alloc(65);
 
     msg = G_oxen_state.io_buffer + G_oxen_state.io_offset;
     monero_io_fetch(NULL, 32);
@@ -52,58 +142,84 @@ int monero_apdu_get_tx_proof(void) {
 
     monero_io_discard(0);
 
-    // Generate random k
-    monero_rng_mod_order(k);
-    // tmp = msg
-    memmove(G_oxen_state.tmp + 32 * 0, msg, 32);
-    // tmp = msg || D
-    memmove(G_oxen_state.tmp + 32 * 1, D, 32);
+    oxen_proof_decompress(Axy, A);
+    if (G_oxen_state.options & 1) oxen_proof_decompress(Bxy, B);
+    oxen_tx_proof_sign(sig_c,
+                       sig_r,
+                       msg,
+                       G_oxen_state.options & 2 ? R : NULL,
+                       D,
+                       Axy,
+                       G_oxen_state.options & 1 ? Bxy : NULL,
+                       r);
+    oxen_scratch_release(mark);
 
-    if (G_oxen_state.options & 1) {
-        // X = kB
-        monero_ecmul_k(XY, B, k);
-    } else {
-        // X = kG
-        monero_ecmul_G(XY, k);
-    }
-    // tmp = msg || D || X
-    memmove(G_oxen_state.tmp + 32 * 2, XY, 32);
+    monero_io_insert(sig_c, 32);
+    monero_io_insert(sig_r, 32);
 
-    // Y = kA
-    monero_ecmul_k(XY, A, k);
-    // tmp = msg || D || X || Y
-    memmove(G_oxen_state.tmp + 32 * 3, XY, 32);
-
-    /* Monero V2 proofs (not currently present in Oxen).
-     *
-     * Note that changing this will require enlarging tmp!
-
-        oxen_keccak_256(&G_oxen_state.keccak_alt, (unsigned char *)"TXPROOF_V2", 10, sep);
-        // tmp = msg || D || X || Y || sep
-        memmove(G_oxen_state.tmp + 32 * 4, sep, 32);
-        // tmp = msg || D || X || Y || sep || R
-        memmove(G_oxen_state.tmp + 32 * 5, R, 32);
-        // tmp = msg || D || X || Y || sep || R || A
-        memmove(G_oxen_state.tmp + 32 * 6, A, 32);
-        // tmp = msg || D || X || Y || sep || R || B or [0]
-        memmove(G_oxen_state.tmp + 32 * 7, B, 32);
-
-        monero_hash_to_scalar(sig_c, &G_oxen_state.tmp[0], 32 * 8);
-    */
-    (void) R;
-
-    // sig_c = H_n(tmp)
-    monero_hash_to_scalar(sig_c, &G_oxen_state.tmp[0], 32 * 4);
-    // Monero V2 proof version:
-    // monero_hash_to_scalar(sig_c, &G_oxen_state.tmp[0], 32 * 8);
+    return SW_OK;
+}
 
-    // sig_c*r
-    monero_multm(XY, sig_c, r);
-    // sig_r = k - sig_c*r
-    monero_subm(sig_r, k, XY);
+/* ----------------------------------------------------------------------- */
+/* ---                          TX PROOF BATCH                         --- */
+/* ----------------------------------------------------------------------- */
+/*
+ * For audits over many payments, outside of a tx:
+ *
+ * [GET_TX_PROOF, 1, 0]: msg(32) || A(32) || B(32), with option bits 0 (B) and 1 (V2) as for a
+ *     single proof; sets the message, recipient and version of the following proofs, until the
+ *     next [1, 0].
+ * [GET_TX_PROOF, 2, 0]: up to TX_PROOF_BATCH_PER_APDU ([R(32) ||] D(32) || wrapped r) entries, R
+ *     only for V2 -> (c || r) for each of them.
+ *
+ * A and B are only decompressed once per [1, 0] rather than once per proof.
+ */
+#define TX_PROOF_BATCH_PER_APDU 2
+int oxen_apdu_get_tx_proof_batch(void) {
+    unsigned char R[TX_PROOF_BATCH_PER_APDU][32];
+    unsigned char D[TX_PROOF_BATCH_PER_APDU][32];
+    unsigned char r[TX_PROOF_BATCH_PER_APDU][32];
+    unsigned char sig_c[32];
+    unsigned char sig_r[32];
+    unsigned int n;
 
-    monero_io_insert(sig_c, 32);
-    monero_io_insert(sig_r, 32);
+    if (G_oxen_state.io_p1 == 1) {
+        monero_io_fetch(G_oxen_state.proof_msg, 32);
+        oxen_proof_decompress(G_oxen_state.proof_Axy,
+                              G_oxen_state.io_buffer + G_oxen_state.io_offset);
+        monero_io_fetch(NULL, 32);
+        G_oxen_state.proof_options = G_oxen_state.options & 3;
+        if (G_oxen_state.proof_options & 1) {
+            oxen_proof_decompress(G_oxen_state.proof_Bxy,
+                                  G_oxen_state.io_buffer + G_oxen_state.io_offset);
+        }
+        monero_io_fetch(NULL, 32);
+        monero_io_discard(1);
+        return SW_OK;
+    }
 
+    for (n = 0; n < TX_PROOF_BATCH_PER_APDU && G_oxen_state.io_offset < G_oxen_state.io_length;
+         n++) {
+        if (G_oxen_state.proof_options & 2) monero_io_fetch(R[n], 32);
+        monero_io_fetch(D[n], 32);
+        monero_io_fetch_decrypt_key(r[n]);
+    }
+    if (n == 0 || G_oxen_state.io_offset != G_oxen_state.io_length) THROW(SW_WRONG_LENGTH);
+    monero_io_discard(0);
+
+    for (unsigned int i = 0; i < n; i++) {
+        oxen_tx_proof_sign(sig_c,
+                           sig_r,
+                           G_oxen_state.proof_msg,
+                           G_oxen_state.proof_options & 2 ? R[i] : NULL,
+                           D[i],
+                           G_oxen_state.proof_Axy,
+                           G_oxen_state.proof_options & 1 ? G_oxen_state.proof_Bxy : NULL,
+                           r[i]);
+        monero_io_insert(sig_c, 32);
+        monero_io_insert(sig_r, 32);
+    }
+    memset(r, 0, sizeof(r));
     return SW_OK;
 }
+#undef TX_PROOF_BATCH_PER_APDU
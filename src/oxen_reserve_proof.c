@@ -0,0 +1,133 @@
+/*****************************************************************************
+ *   Ledger Oxen App.
+ *   (c) 2020 Oxen Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *****************************************************************************/
+
+/*
+ * Reserve proof session.
+ *
+ * A reserve proof needs the key image of every unspent output, signed with the output's secret
+ * key.  Rather than having the host fetch wrapped secret keys and ask for each key image and each
+ * signature separately, the host describes the outputs and the device derives their secret keys
+ * itself, checks them against the output keys and returns (key image, signature) for each.  Every
+ * signed entry also goes into a running SHA-256, which the host gets at the end of the session to
+ * bind the proof to exactly what was signed.  The user confirms the session once; any error ends
+ * it (the error path resets the tx chains, which share the RAM of the session).
+ */
+
+#include "os.h"
+#include "cx.h"
+#include "oxen_types.h"
+#include "oxen_api.h"
+#include "oxen_vars.h"
+
+// R(32) || output index(4) || subaddress index(8) || P(32)
+#define RESERVE_ENTRY_SIZE     (32 + 4 + 8 + 32)
+#define RESERVE_ENTRY_PER_APDU 2
+
+/* ----------------------------------------------------------------------- */
+/* ---                                                                 --- */
+/* ----------------------------------------------------------------------- */
+// x = H_s(8aR || i) + b (+ m for a subaddress), which must be the secret key of P
+static void oxen_reserve_proof_entry(const unsigned char *R,
+                                     unsigned int out_idx,
+                                     const unsigned char *index,
+                                     const unsigned char *P) {
+    unsigned char drv[32];
+    unsigned char x[32];
+    unsigned char xG[32];
+    unsigned char image[32];
+    unsigned char signature[64];
+
+    monero_generate_key_derivation(drv, R, G_oxen_state.view_priv);
+    oxen_subaddr_key_load(index);
+    monero_derive_secret_key(x, drv, out_idx, G_oxen_state.subaddr_key_sec);
+    monero_ecmul_G(xG, x);
+    if (memcmp(xG, P, 32)) {
+        memset(x, 0, 32);
+        clear_protocol();
+        THROW(SW_WRONG_DATA);
+    }
+
+    monero_generate_key_image(image, P, x);
+    oxen_generate_key_image_signature(signature, image, P, x);
+    memset(x, 0, 32);
+
+    oxen_hash_update(&G_oxen_state.reserve_sha256, P, 32);
+    oxen_hash_update(&G_oxen_state.reserve_sha256, image, 32);
+    oxen_hash_update(&G_oxen_state.reserve_sha256, signature, 64);
+    G_oxen_state.reserve_cnt++;
+
+    monero_io_insert(image, 32);
+    monero_io_insert(signature, 64);
+}
+
+/*
+ * [RESERVE_PROOF, 0, 0]: confirms the session with the user.
+ * [RESERVE_PROOF, 1, 0]: up to RESERVE_ENTRY_PER_APDU (R || output index (u32) || subaddress index
+ *     || P) entries -> key image(32) || signature(64) for each of them.
+ * [RESERVE_PROOF, 2, 0]: ends the session -> entry count (u32) || SHA-256 of all the
+ *     (P || key image || signature) returned.
+ */
+int oxen_apdu_reserve_proof(void) {
+    unsigned char R[RESERVE_ENTRY_PER_APDU][32];
+    unsigned int out_idx[RESERVE_ENTRY_PER_APDU];
+    unsigned char index[RESERVE_ENTRY_PER_APDU][8];
+    unsigned char P[RESERVE_ENTRY_PER_APDU][32];
+    unsigned char hash[32];
+    unsigned int n;
+
+    if (G_oxen_state.io_p1 == 0) {
+        monero_io_discard(1);
+        G_oxen_state.tx_special_confirmed = 0;
+        G_oxen_state.reserve_cnt = 0;
+        cx_sha256_init(&G_oxen_state.reserve_sha256);
+        oxen_subaddr_key_wipe();
+        ui_menu_reserve_proof_validation_display();
+        return 0;
+    }
+    if (!G_oxen_state.tx_special_confirmed) {
+        monero_lock_and_throw(SW_WRONG_DATA);
+    }
+
+    if (G_oxen_state.io_p1 == 2) {
+        monero_io_discard(1);
+        oxen_hash_final(&G_oxen_state.reserve_sha256, hash);
+        monero_io_insert_u32(G_oxen_state.reserve_cnt);
+        monero_io_insert(hash, 32);
+        oxen_subaddr_key_wipe();
+        G_oxen_state.tx_special_confirmed = 0;
+        return SW_OK;
+    }
+
+    n = (G_oxen_state.io_length - G_oxen_state.io_offset) / RESERVE_ENTRY_SIZE;
+    if (n == 0 || n > RESERVE_ENTRY_PER_APDU ||
+        G_oxen_state.io_length - G_oxen_state.io_offset != n * RESERVE_ENTRY_SIZE) {
+        clear_protocol();
+        THROW(SW_WRONG_LENGTH);
+    }
+    for (unsigned int i = 0; i < n; i++) {
+        monero_io_fetch(R[i], 32);
+        out_idx[i] = monero_io_fetch_u32();
+        monero_io_fetch(index[i], 8);
+        monero_io_fetch(P[i], 32);
+    }
+    monero_io_discard(0);
+
+    for (unsigned int i = 0; i < n; i++) {
+        oxen_reserve_proof_entry(R[i], out_idx[i], index[i], P[i]);
+    }
+    return SW_OK;
+}
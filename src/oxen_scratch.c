@@ -0,0 +1,94 @@
+/*****************************************************************************
+ *   Ledger Oxen App.
+ *   (c) 2020 Oxen Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *****************************************************************************/
+
+/*
+ * Scratch arena.
+ *
+ * Large temporaries (field element registers, decompressed points, CLSAG scalars) come from a
+ * stack-like arena in G_oxen_state rather than from the call stack or from whatever buffer happens
+ * to be idle.  A scope takes a mark, allocates, and releases back to the mark, which also wipes
+ * what it used:
+ *
+ *     unsigned int mark = oxen_scratch_mark();
+ *     unsigned char *u = oxen_scratch_alloc(32);
+ *     ...
+ *     oxen_scratch_release(mark);
+ *
+ * Every command starts with an empty arena, so a scope left by an exception costs nothing; the
+ * arena is also wiped when a command fails and on lock, so that no secret outlives its command.
+ * Debug builds put a canary after each allocation, check the canaries of everything a release
+ * frees, and keep the high-water mark (GET_KEY [6]).
+ */
+
+#include "os.h"
+#include "cx.h"
+#include "oxen_types.h"
+#include "oxen_api.h"
+#include "oxen_vars.h"
+
+#define SCRATCH_CANARY 0xA5
+
+/* ----------------------------------------------------------------------- */
+/* ---                                                                 --- */
+/* ----------------------------------------------------------------------- */
+void oxen_scratch_reset(void) {
+    memset(G_oxen_state.scratch, 0, G_oxen_state.scratch_top);
+    G_oxen_state.scratch_top = 0;
+#if DEBUG_HWDEVICE
+    G_oxen_state.scratch_canary_cnt = 0;
+#endif
+}
+
+unsigned int oxen_scratch_mark(void) {
+    return G_oxen_state.scratch_top;
+}
+
+unsigned char *oxen_scratch_alloc(unsigned int len) {
+    unsigned int top = G_oxen_state.scratch_top;
+
+#if DEBUG_HWDEVICE
+    if (G_oxen_state.scratch_canary_cnt == SCRATCH_MAX_ALLOCS) THROW(SW_SECURITY_INTERNAL);
+    if (len + 1 > sizeof(G_oxen_state.scratch) - top) THROW(SW_SECURITY_INTERNAL);
+    G_oxen_state.scratch[top + len] = SCRATCH_CANARY;
+    G_oxen_state.scratch_canary[G_oxen_state.scratch_canary_cnt++] = top + len;
+    G_oxen_state.scratch_top = top + len + 1;
+    if (G_oxen_state.scratch_top > G_oxen_state.scratch_high) {
+        G_oxen_state.scratch_high = G_oxen_state.scratch_top;
+    }
+#else
+    if (len > sizeof(G_oxen_state.scratch) - top) THROW(SW_SECURITY_INTERNAL);
+    G_oxen_state.scratch_top = top + len;
+#endif
+    return G_oxen_state.scratch + top;
+}
+
+void oxen_scratch_release(unsigned int mark) {
+    if (mark > G_oxen_state.scratch_top) THROW(SW_SECURITY_INTERNAL);
+#if DEBUG_HWDEVICE
+    // Anything written past the end of its allocation shows up on a canary
+    while (G_oxen_state.scratch_canary_cnt &&
+           G_oxen_state.scratch_canary[G_oxen_state.scratch_canary_cnt - 1] >= mark) {
+        G_oxen_state.scratch_canary_cnt--;
+        if (G_oxen_state.scratch[G_oxen_state.scratch_canary[G_oxen_state.scratch_canary_cnt]] !=
+            SCRATCH_CANARY) {
+            THROW(SW_SECURITY_INTERNAL);
+        }
+    }
+#endif
+    memset(G_oxen_state.scratch + mark, 0, G_oxen_state.scratch_top - mark);
+    G_oxen_state.scratch_top = mark;
+}
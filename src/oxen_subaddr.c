@@ -0,0 +1,206 @@
+/*****************************************************************************
+ *   Ledger Oxen App.
+ *   (c) 2020 Oxen Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *****************************************************************************/
+
+/*
+ * Subaddress table.
+ *
+ * An optional NVRAM table of the (C, D) public keys of the first subaddresses, for wallets that
+ * keep asking for the same few (deposit addresses).  It covers major < majors and minor < minors,
+ * as set up with INS_SUBADDRESS_TABLE, and only gets filled by that command (a few entries at a
+ * time, whenever the host is idle): lookups never write.  The table is tied to the wallet it was
+ * built for, so it is simply ignored after a change of keys or network; whether it matches is
+ * checked once per monero_init() and kept in RAM.
+ *
+ * It lives in flash: a (re)start of the table needs an on-screen confirmation, and each entry only
+ * gets written once per table.
+ */
+
+#include "os.h"
+#include "cx.h"
+#include "oxen_types.h"
+#include "oxen_api.h"
+#include "oxen_vars.h"
+
+// Entries computed per [SUBADDRESS_TABLE, 2] command
+#define SUBADDR_TABLE_BUILD_STEP 4
+
+#define N_table (&N_oxen_state->subaddr_table)
+
+static void oxen_subaddr_table_check(unsigned char *check) {
+    cx_sha256_t sha256;
+    unsigned char c = N_oxen_state->network_id;
+
+    cx_sha256_init(&sha256);
+    oxen_hash_update(&sha256, G_oxen_state.view_priv, 32);
+    oxen_hash_update(&sha256, G_oxen_state.spend_pub, 32);
+    oxen_hash_update(&sha256, &c, 1);
+    oxen_hash_final(&sha256, check);
+}
+
+// Whether the table was built for the loaded keys and network
+static int oxen_subaddr_table_bound(void) {
+    unsigned char check[32];
+
+    if (G_oxen_state.subaddr_table_bound == SUBADDR_TABLE_UNCHECKED) {
+        oxen_subaddr_table_check(check);
+        G_oxen_state.subaddr_table_bound = memcmp(check, (void *) N_table->check, 32)
+                                               ? SUBADDR_TABLE_FOREIGN
+                                               : SUBADDR_TABLE_BOUND;
+    }
+    return G_oxen_state.subaddr_table_bound == SUBADDR_TABLE_BOUND;
+}
+
+// Returns the entry number of index in the table, or -1 if the table does not cover it
+static int oxen_subaddr_table_entry(const unsigned char *index) {
+    unsigned int major, minor;
+
+    if (N_table->majors == 0) return -1;
+    major = (index[0] << 0) | (index[1] << 8) | (index[2] << 16) | (index[3] << 24);
+    minor = (index[4] << 0) | (index[5] << 8) | (index[6] << 16) | (index[7] << 24);
+    if (major >= N_table->majors || minor >= N_table->minors || (major | minor) == 0) return -1;
+
+    if (!oxen_subaddr_table_bound()) return -1;
+    return major * N_table->minors + minor;
+}
+
+static int oxen_subaddr_table_valid(unsigned int i) {
+    return (N_table->valid[i / 8] & (1 << (i % 8))) != 0;
+}
+
+static void oxen_subaddr_table_put(unsigned int i, const unsigned char *C, const unsigned char *D) {
+    unsigned char v;
+
+    nvm_write((void *) N_table->CD[i], (void *) C, 32);
+    nvm_write((void *) (N_table->CD[i] + 32), (void *) D, 32);
+    v = N_table->valid[i / 8] | (1 << (i % 8));
+    nvm_write((void *) &N_table->valid[i / 8], &v, 1);
+}
+
+/* ----------------------------------------------------------------------- */
+/* ---                                                                 --- */
+/* ----------------------------------------------------------------------- */
+// C may be NULL when only D is wanted
+int oxen_subaddr_table_get(unsigned char *C, unsigned char *D, const unsigned char *index) {
+    int i = oxen_subaddr_table_entry(index);
+
+    if (i < 0 || !oxen_subaddr_table_valid(i)) return 0;
+    if (C) memmove(C, (void *) N_table->CD[i], 32);
+    memmove(D, (void *) (N_table->CD[i] + 32), 32);
+    return 1;
+}
+
+// Whether (C, D) is one of the subaddresses of the table
+int oxen_subaddr_table_find(const unsigned char *C, const unsigned char *D) {
+    unsigned int i, n;
+
+    if (N_table->majors == 0 || !oxen_subaddr_table_bound()) return 0;
+    n = N_table->majors * N_table->minors;
+    for (i = 1; i < n; i++) {
+        if (oxen_subaddr_table_valid(i) && memcmp((void *) N_table->CD[i], C, 32) == 0 &&
+            memcmp((void *) (N_table->CD[i] + 32), D, 32) == 0)
+            return 1;
+    }
+    return 0;
+}
+
+/* ----------------------------------------------------------------------- */
+/* ---                       SUBADDRESS TABLE                          --- */
+/* ----------------------------------------------------------------------- */
+/*
+ * [SUBADDRESS_TABLE, 0, 0]: disables the table.
+ * [SUBADDRESS_TABLE, 1, 0]: majors(1) || minors(1); once confirmed on screen, (re)starts an empty
+ *     table covering major < majors, minor < minors, with majors * minors <= SUBADDR_TABLE_SIZE.
+ * [SUBADDRESS_TABLE, 2, 0]: computes the next few missing entries -> entries still missing (u16)
+ */
+int oxen_apdu_subaddr_table(void) {
+    unsigned char index[8];
+    unsigned char C[32];
+    unsigned char D[32];
+    unsigned char majors, minors;
+    unsigned int i, n, done, missing;
+
+    switch (G_oxen_state.io_p1) {
+        case 0:
+            monero_io_discard(1);
+            if (N_table->majors != 0) {
+                majors = 0;
+                nvm_write((void *) &N_table->majors, &majors, 1);
+            }
+            return SW_OK;
+
+        case 1:
+            majors = monero_io_fetch_u8();
+            minors = monero_io_fetch_u8();
+            monero_io_discard(1);
+            if (majors == 0 || minors == 0 || majors * minors > SUBADDR_TABLE_SIZE) {
+                THROW(SW_WRONG_DATA_RANGE);
+            }
+            G_oxen_state.subaddr_pending[0] = majors;
+            G_oxen_state.subaddr_pending[1] = minors;
+            snprintf(G_oxen_state.ux_amount,
+                     sizeof(G_oxen_state.ux_amount),
+                     "%u x %u",
+                     majors,
+                     minors);
+            ui_menu_subaddr_table_display();
+            return 0;
+
+        case 2:
+            monero_io_discard(1);
+            if (!oxen_subaddr_table_bound()) {
+                // Built for other keys or another network: needs a new [SUBADDRESS_TABLE, 1]
+                THROW(SW_COMMAND_NOT_ALLOWED);
+            }
+            n = N_table->majors * N_table->minors;
+            done = 0;
+            missing = 0;
+            memset(index, 0, sizeof(index));
+            // Entry 0 is the main address: never stored
+            for (i = 1; i < n; i++) {
+                if (oxen_subaddr_table_valid(i)) continue;
+                if (done == SUBADDR_TABLE_BUILD_STEP) {
+                    missing++;
+                    continue;
+                }
+                index[0] = i / N_table->minors;
+                index[4] = i % N_table->minors;
+                // Computed, as it misses the table
+                monero_get_subaddress(C, D, index);
+                oxen_subaddr_table_put(i, C, D);
+                done++;
+            }
+            monero_io_insert_u16(missing);
+            return SW_OK;
+
+        default:
+            THROW(SW_WRONG_P1P2);
+    }
+    return SW_OK;
+}
+
+// Called from the UI once the user accepted the [SUBADDRESS_TABLE, 1] size in subaddr_pending
+void oxen_subaddr_table_confirmed(void) {
+    unsigned char check[32];
+
+    oxen_subaddr_table_check(check);
+    nvm_write((void *) &N_table->majors, NULL, 1);
+    nvm_write((void *) N_table->valid, NULL, sizeof(N_table->valid));
+    nvm_write((void *) N_table->check, check, 32);
+    nvm_write((void *) &N_table->minors, &G_oxen_state.subaddr_pending[1], 1);
+    nvm_write((void *) &N_table->majors, &G_oxen_state.subaddr_pending[0], 1);
+    G_oxen_state.subaddr_table_bound = SUBADDR_TABLE_BOUND;
+}
@@ -0,0 +1,97 @@
+/*****************************************************************************
+ *   Ledger Oxen App.
+ *   (c) 2020 Oxen Project
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *****************************************************************************/
+
+/*
+ * Tx integrity transcript.
+ *
+ * The host sends the outputs of a tx twice (for their keys, then for the prehash) and the output
+ * commitments twice (in the prehash, then in its finalization); each time the second pass must
+ * match the first.  The transcript keeps one 32-byte lane per such check:
+ *
+ *     lane' = keccak(lane id || lane || record)
+ *
+ * so a record costs one one-shot hash, whatever the lane, and the whole thing takes no hash
+ * context while idle.  A lane is snapshotted at the end of the first pass, which restarts it for
+ * the second, and checked against its snapshot at the end of the second.
+ */
+
+#include "os.h"
+#include "cx.h"
+#include "oxen_types.h"
+#include "oxen_api.h"
+#include "oxen_vars.h"
+
+#define TRANSCRIPT_OUTPUT_SIZE (32 + 32 + 1 + 32)
+
+/* ----------------------------------------------------------------------- */
+/* ---                                                                 --- */
+/* ----------------------------------------------------------------------- */
+void oxen_transcript_reset(void) {
+    memset(&G_oxen_state.transcript, 0, sizeof(G_oxen_state.transcript));
+}
+
+// Lays out lane id || lane in the arena, for the caller to append its record
+static unsigned char *oxen_transcript_begin(unsigned int lane, unsigned int len) {
+    unsigned char *buf = oxen_scratch_alloc(1 + 32 + len);
+
+    buf[0] = lane;
+    memmove(buf + 1, G_oxen_state.transcript.lane[lane], 32);
+    return buf;
+}
+
+static void oxen_transcript_end(unsigned int lane, const unsigned char *buf, unsigned int len) {
+    oxen_keccak_256(&G_oxen_state.keccak, buf, 1 + 32 + len, G_oxen_state.transcript.lane[lane]);
+}
+
+void oxen_transcript_absorb(unsigned int lane, const unsigned char *record, unsigned int len) {
+    unsigned int mark = oxen_scratch_mark();
+    unsigned char *buf = oxen_transcript_begin(lane, len);
+
+    memmove(buf + 1 + 32, record, len);
+    oxen_transcript_end(lane, buf, len);
+    oxen_scratch_release(mark);
+}
+
+// Output record: A || B || is_change || amount key
+void oxen_transcript_absorb_output(const unsigned char *A,
+                                   const unsigned char *B,
+                                   unsigned char is_change,
+                                   const unsigned char *amount_key) {
+    unsigned int mark = oxen_scratch_mark();
+    unsigned char *buf = oxen_transcript_begin(TRANSCRIPT_OUTPUTS, TRANSCRIPT_OUTPUT_SIZE);
+    unsigned char *record = buf + 1 + 32;
+
+    memmove(record, A, 32);
+    memmove(record + 32, B, 32);
+    record[64] = is_change;
+    memmove(record + 65, amount_key, 32);
+    oxen_transcript_end(TRANSCRIPT_OUTPUTS, buf, TRANSCRIPT_OUTPUT_SIZE);
+    oxen_scratch_release(mark);
+}
+
+void oxen_transcript_snapshot(unsigned int lane) {
+    memmove(G_oxen_state.transcript.snapshot[lane], G_oxen_state.transcript.lane[lane], 32);
+    memset(G_oxen_state.transcript.lane[lane], 0, 32);
+}
+
+// The second pass must have absorbed exactly the records of the first one
+void oxen_transcript_check(unsigned int lane, int sw) {
+    if (memcmp(G_oxen_state.transcript.lane[lane], G_oxen_state.transcript.snapshot[lane], 32)) {
+        monero_lock_and_throw(sw);
+    }
+    memset(G_oxen_state.transcript.lane[lane], 0, 32);
+}
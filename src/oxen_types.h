@@ -70,6 +70,47 @@ enum network_type {
     FAKECHAIN = 3
 };
 
+/* Unattended signing policy, set up with INS_SET_POLICY */
+#define POLICY_MAX_DESTS 16
+// policy.spent gets written ahead by budget / POLICY_RESERVE_PARTS, see oxen_policy_charge_tx()
+#define POLICY_RESERVE_PARTS 16
+typedef struct oxen_policy_t {
+    unsigned char enabled;
+    // (1 << TXTYPE_*) for each tx type whose prompts the policy may skip
+    unsigned char tx_types;
+    // Caps, in atomic OXEN: the recipient total of a tx, the fee of a tx, and the total of all the
+    // recipient amounts approved by the policy (the budget) since it was last set
+    uint64_t max_tx_amount;
+    uint64_t max_fee;
+    uint64_t budget;
+    // Can be ahead of what was approved by the reserve in RAM (policy_reserved)
+    uint64_t spent;
+    // keccak(A || B) of the allowed recipients
+    unsigned char dest_cnt;
+    unsigned char dests[POLICY_MAX_DESTS][32];
+} oxen_policy_t;
+
+/* Precomputed subaddresses (C, D) for major < majors, minor < minors; see oxen_subaddr.c */
+#ifdef TARGET_NANOS
+#define SUBADDR_TABLE_SIZE 32
+#else
+#define SUBADDR_TABLE_SIZE 128
+#endif
+typedef struct oxen_subaddr_table_t {
+    // sha256(view_priv || spend_pub || network_id) of the wallet the entries belong to
+    unsigned char check[32];
+    unsigned char majors;
+    unsigned char minors;
+    // Entry i (= major * minors + minor) has been computed
+    unsigned char valid[SUBADDR_TABLE_SIZE / 8];
+    unsigned char CD[SUBADDR_TABLE_SIZE][64];
+} oxen_subaddr_table_t;
+
+/* subaddr_table_bound */
+#define SUBADDR_TABLE_UNCHECKED 0
+#define SUBADDR_TABLE_BOUND     1
+#define SUBADDR_TABLE_FOREIGN   2
+
 typedef struct oxen_nv_state_t {
     /* magic */
     unsigned char magic[8];
@@ -118,6 +159,25 @@ typedef struct oxen_nv_state_t {
         char words[26][WORDS_MAX_LENGTH];
         char words_list[25 * WORDS_MAX_LENGTH + 25];
     };
+
+#define CONFIRM_OUTPUTS_EACH    0  // One confirmation per output
+#define CONFIRM_OUTPUTS_SUMMARY 1  // One summary confirmation for all outputs of a standard tx
+    /* output confirmation mode */
+    unsigned char confirm_outputs_mode;
+
+    /* unattended signing policy */
+    oxen_policy_t policy;
+
+    /* Public keys and base address, so that boot can skip the two ecmuls and the base58 encoding.
+     * Only used while pub_cache_check matches the private keys and network they belong to. */
+    unsigned char cached_view_pub[32];
+    unsigned char cached_spend_pub[32];
+    unsigned char cached_address_len;
+    char cached_address[97];
+    unsigned char pub_cache_check[32];
+
+    /* subaddress table */
+    oxen_subaddr_table_t subaddr_table;
 } oxen_nv_state_t;
 
 enum device_mode { NONE, TRANSACTION_CREATE_REAL, TRANSACTION_CREATE_FAKE, TRANSACTION_PARSE };
@@ -130,6 +190,62 @@ enum txtype { TXTYPE_STANDARD, TXTYPE_STATE_CHANGE, TXTYPE_UNLOCK, TXTYPE_STAKE,
 
 #define MONERO_IO_BUFFER_LENGTH 288
 
+/* Inputs that can be prepared, hashed and signed as one CLSAG batch */
+#ifdef TARGET_NANOS
+#define CLSAG_MAX_SLOTS 2
+#else
+#define CLSAG_MAX_SLOTS 8
+#endif
+
+typedef struct oxen_clsag_slot_t {
+    unsigned char p[32];
+    unsigned char z[32];
+    unsigned char c[32];
+} oxen_clsag_slot_t;
+
+/* Scratch arena (see oxen_scratch.c): sized for its largest user, the 9 field registers of
+ * monero_ge_fromfe_frombytes.  The same space also takes the decompressed points of the ec helpers
+ * (up to 2 x 65) and of the tx proofs (2 x 65, around the helpers), which used to be stack arrays
+ * on the deepest call paths; the H_p(P) points stay on the stack, as they are live across
+ * monero_ge_fromfe_frombytes.  Debug builds add a canary byte per allocation. */
+#define SCRATCH_SIZE       (9 * 32)
+#define SCRATCH_MAX_ALLOCS 16
+
+/* Recent key derivations, looked up by a truncated HMAC of (P, scalar); see oxen_crypto.c */
+#ifdef TARGET_NANOS
+#define DRV_CACHE_SIZE 3
+#else
+#define DRV_CACHE_SIZE 8
+#endif
+
+/* Integrity transcript lanes (see oxen_transcript.c): the outputs, sent for their keys and again
+ * for the prehash, and their commitments, sent in the prehash and again in its finalization */
+#define TRANSCRIPT_OUTPUTS     0
+#define TRANSCRIPT_COMMITMENTS 1
+#define TRANSCRIPT_LANES       2
+
+typedef struct oxen_transcript_t {
+    unsigned char lane[TRANSCRIPT_LANES][32];
+    unsigned char snapshot[TRANSCRIPT_LANES][32];
+} oxen_transcript_t;
+
+typedef struct oxen_drv_cache_t {
+    unsigned char tag[16];
+    unsigned char drv[32];
+} oxen_drv_cache_t;
+
+/* Recent hash_to_ec results, as uncompressed points (04 || x || y), most recent first */
+#ifdef TARGET_NANOS
+#define HP_CACHE_SIZE 1
+#else
+#define HP_CACHE_SIZE 4
+#endif
+
+typedef struct oxen_hp_cache_t {
+    unsigned char P[32];
+    unsigned char Hxy[65];
+} oxen_hp_cache_t;
+
 typedef struct oxen_v_state_t {
     unsigned char state;
     unsigned char protocol;
@@ -167,6 +283,17 @@ typedef struct oxen_v_state_t {
     /* Tx state machine */
     unsigned char tx_in_progress : 1;
     unsigned char tx_special_confirmed : 1;
+    unsigned char tx_outputs_done : 1;
+    unsigned char tx_policy_miss : 1;
+    /* Multi-tx session with an approved recipient cap, and whether the current tx went beyond it */
+    unsigned char tx_session : 1;
+    unsigned char tx_session_miss : 1;
+    /* VALIDATE prompt pipeline: a prompt whose command has already been answered is on screen;
+     * the next command is held until the user answers it; the user rejected with no command
+     * held, so the next one gets denied */
+    unsigned char ux_pending : 1;
+    unsigned char ux_queued : 1;
+    unsigned char ux_deny_pending : 1;
     unsigned char tx_type;
     unsigned char tx_cnt;
     unsigned char tx_sig_mode;
@@ -174,57 +301,150 @@ typedef struct oxen_v_state_t {
     unsigned char tx_state_p1;
     unsigned char tx_state_p2;
     unsigned char tx_output_cnt;
+    unsigned char tx_additional_key_cnt;
+    /* Unlock signatures still to make in a confirmed [GEN_UNLOCK_SIGNATURE, 0, N] batch */
+    unsigned char unlock_batch_left;
+    /* ONS records still to sign in a confirmed [GEN_ONS_SIGNATURE, 0, N] batch */
+    unsigned char lns_batch_left;
+    /* Messages still to sign in a confirmed [SIGN_MESSAGE, 0, N] batch */
+    unsigned char msg_batch_left;
     unsigned int tx_sign_cnt;
 
+    /* CLSAG batch: prepared, hashed and signed slots */
+    unsigned char clsag_slot_cnt;
+    unsigned char clsag_slot_hashed;
+    unsigned char clsag_slot_signed;
+    /* A [CLSAG, 1, 0] input not signed by [CLSAG, 3, 0] yet */
+    unsigned char clsag_unsigned;
+
     /* sc_add control */
     unsigned char last_derive_secret_key[32];
     unsigned char last_get_subaddress_secret_key[32];
 
+    /* Spend keys of the last subaddress used by a batch, kept for its next entries on the same
+     * subaddress */
+    unsigned char subaddr_key_index[8];
+    unsigned char subaddr_key_sec[32];
+    unsigned char subaddr_key_pub[32];
+    unsigned char subaddr_key_set;
+
+    /* Whether the subaddress table check matches the loaded keys and network
+     * (SUBADDR_TABLE_*), worked out on the first lookup after monero_init() */
+    unsigned char subaddr_table_bound;
+
     /* ------------------------------------------ */
     /* ---               Crypto               --- */
     /* ------------------------------------------ */
-    union {
-        struct {
-            unsigned char view_priv[32];
-            unsigned char view_pub[32];
-            unsigned char spend_priv[32];
-            unsigned char spend_pub[32];
-        };
-        unsigned char keys[128];
-    };
-
-    /* SPK */
-    cx_aes_key_t spk;
     unsigned char hmac_key[32];
+    /* Key of the TYPE_ALPHA hmacs, drawn again for each tx of a session: an alpha never outlives
+     * its (sub-)tx */
+    unsigned char alpha_key[32];
 
     /* Tx key */
     unsigned char R[32];
     unsigned char r[32];
+    /* Change derivation 8.a.R (== 8.r.A), computed once R is known */
+    unsigned char change_derivation[32];
+    /* Seed of the additional tx keys generated by INS_GET_ADDITIONAL_KEY */
+    unsigned char additional_key_seed[32];
+
+    /* Key derivation cache: filled entries, and the next one to replace */
+    oxen_drv_cache_t drv_cache[DRV_CACHE_SIZE];
+    unsigned char drv_cache_cnt;
+    unsigned char drv_cache_next;
+#if DEBUG_HWDEVICE
+    unsigned int drv_cache_hits;
+    unsigned int drv_cache_misses;
+#endif
 
-    /* hashing */
-    union {
-        cx_sha3_t keccak;
-        cx_blake2b_t blake2b;
-    };
+    /* H_p(P) cache, shared by key images and their signatures */
+    oxen_hp_cache_t hp_cache[HP_CACHE_SIZE];
+    unsigned char hp_cache_cnt;
+
+    /* hashing: keccak for one-shot hashes, which any command can do, and keccak_alt for the
+     * prefix, prehash and CLSAG hashes, which span most of a tx.  Hashes that stream over several
+     * APDUs of one phase (integrity transcript, reserve proofs, messages, ONS records) are in the
+     * phase pool below instead, where other commands can't clobber them between chunks. */
+    cx_sha3_t keccak;
     cx_sha3_t keccak_alt;
-    cx_sha256_t sha256;
-    cx_sha256_t sha256_alt;
     unsigned char prefixH[32];
     union {
         unsigned char clsag_c[32];
-        unsigned char commitment_hash[32];
-        unsigned char addr_checksum_hash[32];
         unsigned char lns_hash[32];
+        // INS_SET_POLICY data waiting for the user's confirmation (never during a tx)
+        unsigned char policy_pending[32];
+        // INS_SUBADDRESS_TABLE size waiting for the user's confirmation (likewise)
+        unsigned char subaddr_pending[2];
     };
 
-    /* -- track tx-in/out -- */
-    unsigned char OUTK[32];
+    /* Payout summary: accumulated over the (transcript checked) outputs, shown after the last */
+    uint64_t summary_total;
+    uint64_t summary_change;
+    unsigned char summary_dest_cnt;
+    unsigned char summary_multi_dest;
+    /* Recipient total of the tx approved by the policy so far */
+    uint64_t policy_tx_total;
+    /* Session cap approved at [OPEN_TX, 1, 0]: hash of its recipient, what is left of it for the
+     * next sub-txes, and what the current tx sends within it so far */
+    unsigned char session_dest[32];
+    uint64_t session_left;
+    uint64_t session_tx_total;
+
+    /* CLSAG batch: the alphas are derived from the seed, the rest is kept per slot */
+    unsigned char clsag_seed[32];
+
+    /* Phase pool: each arm belongs to a phase that monero_dispatch keeps apart from the others
+     * (a CLSAG only follows the last [VALIDATE, 3]; proofs, messages and ONS records never run
+     * during a tx) */
+    union {
+        oxen_clsag_slot_t clsag_slots[CLSAG_MAX_SLOTS];
+        /* OPEN_TX to the end of VALIDATE: the integrity transcript, the prompt to show next, and
+         * the first recipient (A || B) of the payout summary */
+        struct {
+            oxen_transcript_t transcript;
+            unsigned char prompt_screen;
+            unsigned char prompt_is_subaddress;
+            unsigned char prompt_A[32];
+            unsigned char prompt_B[32];
+            uint64_t prompt_amount;
+            unsigned char summary_dest_is_subaddress;
+            unsigned char summary_dest[64];
+        };
+        /* GET_TX_PROOF batch (never during a tx): message and decompressed recipient */
+        struct {
+            unsigned char proof_msg[32];
+            unsigned char proof_Axy[65];
+            unsigned char proof_Bxy[65];
+            unsigned char proof_options;
+        };
+        /* RESERVE_PROOF session (never during a tx): hash and count of the entries signed */
+        struct {
+            cx_sha256_t reserve_sha256;
+            unsigned int reserve_cnt;
+        };
+        /* SIGN_MESSAGE batch (never during a tx): hash of the message coming in chunks */
+        cx_sha3_t message_keccak;
+        /* GEN_ONS_SIGNATURE (never during a tx): hash of the record coming in chunks, until it is
+         * final in lns_hash */
+        cx_blake2b_t lns_blake2b;
+    };
 
     /* ------------------------------------------ */
-    /* ---               UI/UX                --- */
+    /* ---              Scratch               --- */
     /* ------------------------------------------ */
-    char ux_wallet_public_short_address[7 + 2 + 3 + 1];  // first 7, two dots, last 3, null
+#if DEBUG_HWDEVICE
+    unsigned char scratch[SCRATCH_SIZE + SCRATCH_MAX_ALLOCS];
+    unsigned short scratch_canary[SCRATCH_MAX_ALLOCS];
+    unsigned char scratch_canary_cnt;
+    unsigned short scratch_high;
+#else
+    unsigned char scratch[SCRATCH_SIZE];
+#endif
+    unsigned short scratch_top;
 
+    /* ------------------------------------------ */
+    /* ---               UI/UX                --- */
+    /* ------------------------------------------ */
     union {
         struct {
             char ux_info1[17];
@@ -253,8 +473,33 @@ typedef struct oxen_v_state_t {
             // 0, but won't be if the value is greater than 9 digits).
             char ux_amount[22];
         };
-        unsigned char tmp[160];  // Used as extra temp storage in oxen_proof, oxen_clsag
     };
+
+    /* ------------------------------------------ */
+    /* ---        Derived keys (warm)         --- */
+    /* ------------------------------------------ */
+    /* Everything from keys_tag to the end survives monero_init() (RESET, IO reset) as long as
+     * keys_tag still matches the keys, SPK and short address, so the keys only get derived again
+     * after a lock or a change of network or keys.  Must stay last. */
+    unsigned char keys_tag[32];
+    union {
+        struct {
+            unsigned char view_priv[32];
+            unsigned char view_pub[32];
+            unsigned char spend_priv[32];
+            unsigned char spend_pub[32];
+        };
+        unsigned char keys[128];
+    };
+
+    /* SPK */
+    cx_aes_key_t spk;
+
+    /* Part of policy.spent in NVRAM not used by any tx yet (kept warm: dropping it only wastes
+     * budget) */
+    uint64_t policy_reserved;
+
+    char ux_wallet_public_short_address[7 + 2 + 3 + 1];  // first 7, two dots, last 3, null
 } oxen_v_state_t;
 
 #define STATE_IDLE 0xC0
@@ -280,6 +525,19 @@ typedef struct oxen_v_state_t {
 
 #define INS_RESET        0x02
 #define INS_LOCK_DISPLAY 0x04
+#define INS_HELLO        0x06
+
+/* ---  Capabilities reported by INS_HELLO  --- */
+#define OXEN_CAP_CLSAG_SLOTS     0x00000001
+#define OXEN_CAP_OPEN_SUBTX      0x00000002
+#define OXEN_CAP_POLICY          0x00000004
+#define OXEN_CAP_PROMPT_PIPELINE 0x00000008
+#define OXEN_CAP_SUBADDR_TABLE   0x00000010
+#define OXEN_CAP_BATCH_UNLOCK    0x00000020
+#define OXEN_CAP_BATCH_ONS       0x00000040
+#define OXEN_CAP_BATCH_TX_PROOF  0x00000080
+#define OXEN_CAP_RESERVE_PROOF   0x00000100
+#define OXEN_CAP_SIGN_MESSAGE    0x00000200
 
 #define INS_GET_NETWORK   0x10
 #define INS_RESET_NETWORK 0x11
@@ -305,6 +563,7 @@ typedef struct oxen_v_state_t {
 #define INS_GET_SUBADDRESS                  0x48
 #define INS_GET_SUBADDRESS_SPEND_PUBLIC_KEY 0x4A
 #define INS_GET_SUBADDRESS_SECRET_KEY       0x4C
+#define INS_SUBADDRESS_TABLE                0x4E
 
 #define INS_OPEN_TX             0x70
 #define INS_SET_SIGNATURE_MODE  0x72
@@ -320,10 +579,14 @@ typedef struct oxen_v_state_t {
 #define INS_CLSAG               0x7F
 #define INS_CLOSE_TX            0x80
 
+#define INS_SET_POLICY 0x90
+
 #define INS_GET_TX_PROOF            0xA0
 #define INS_GEN_UNLOCK_SIGNATURE    0xA2
 #define INS_GEN_ONS_SIGNATURE       0xA3
 #define INS_GEN_KEY_IMAGE_SIGNATURE 0xA4
+#define INS_RESERVE_PROOF           0xA5
+#define INS_SIGN_MESSAGE            0xA6
 
 #define INS_GET_RESPONSE 0xc0
 
@@ -50,6 +50,10 @@ void ui_menu_pinlock_display(void) {
 
     os_global_pin_invalidate();
     G_oxen_state.protocol_barrier = PROTOCOL_LOCKED_UNLOCKABLE;
+    oxen_forget_keys();
+    oxen_drv_cache_wipe();
+    oxen_subaddr_key_wipe();
+    oxen_scratch_reset();
     ux_params.ux_id = BOLOS_UX_VALIDATE_PIN;
     ux_params.len = sizeof(ux_params.u.validate_pin);
     ux_params.u.validate_pin.cancellable = 0;
@@ -64,9 +68,10 @@ void ui_menu_pinlock_display(void) {
 #define UI_SETTINGS_FEE_CONFIRM     2
 #define UI_SETTINGS_ADDRESS_CONFIRM 3
 #define UI_SETTINGS_CHANGE_CONFIRM  4
-#define UI_SETTINGS_SELECT_NETWORK  5
-#define UI_SETTINGS_RESET           6
-#define UI_SETTINGS_BACK            7
+#define UI_SETTINGS_OUTPUTS_CONFIRM 5
+#define UI_SETTINGS_SELECT_NETWORK  6
+#define UI_SETTINGS_RESET           7
+#define UI_SETTINGS_BACK            8
 
 void ui_menu_settings_display(void);
 void ui_menu_settings_display_select(unsigned int idx);
@@ -183,6 +188,10 @@ UX_FLOW(ux_flow_timelock,
 
 void ui_menu_amount_validation_action(unsigned int value) {
     unsigned short sw;
+    if (G_oxen_state.ux_pending) {
+        oxen_prehash_prompt_answered(value == ACCEPT);
+        return;
+    }
     if (value == ACCEPT) {
         sw = SW_OK;
     } else {
@@ -231,6 +240,10 @@ void ui_menu_validation_display(void) {
 
 void ui_menu_validation_action(unsigned int value) {
     unsigned short sw;
+    if (G_oxen_state.ux_pending) {
+        oxen_prehash_prompt_answered(value == ACCEPT);
+        return;
+    }
     if (value == ACCEPT) {
         sw = SW_OK;
     } else {
@@ -255,6 +268,27 @@ void ui_menu_stake_validation_display(void) {
     ux_flow_init(0, ux_flow_stake_validation, NULL);
 }
 
+// Payout summary (CONFIRM_OUTPUTS_SUMMARY): one confirmation for all the outputs of a standard tx
+UX_STEP_NOCB(ux_menu_summary_outputs_step, bn, {"Confirm Payout", G_oxen_state.ux_addr_type});
+UX_STEP_NOCB(ux_menu_summary_amount_step, bn, {"Total Amount", G_oxen_state.ux_amount});
+UX_STEP_NOCB(ux_menu_summary_recipient_step,
+             bnnn_paging,
+             {"Recipient", G_oxen_state.ux_address});
+UX_STEP_NOCB(ux_menu_summary_change_step, bn, {"Change", G_oxen_state.ux_addr_info});
+
+UX_FLOW(ux_flow_summary_validation,
+        &ux_menu_summary_outputs_step,
+        &ux_menu_summary_amount_step,
+        &ux_menu_summary_recipient_step,
+        &ux_menu_summary_change_step,
+        &ux_menu_validation_accept_step,
+        &ux_menu_validation_reject_step,
+        FLOW_LOOP);
+
+void ui_menu_summary_validation_display(void) {
+    ux_flow_init(0, ux_flow_summary_validation, NULL);
+}
+
 /** Common menu items for special transaction (i.e. unlocks and ONS) */
 void ui_menu_special_validation_action(unsigned int value) {
     unsigned short sw;
@@ -281,6 +315,17 @@ void ui_menu_unlock_validation_display(void) {
     ux_flow_init(0, ux_flow_unlock_validation, NULL);
 }
 
+UX_STEP_NOCB(ux_menu_unlock_batch_validation_step,
+             bn,
+             {"Unlock Stakes", G_oxen_state.ux_addr_type});
+UX_FLOW(ux_flow_unlock_batch_validation,
+        &ux_menu_unlock_batch_validation_step,
+        &ux_menu_special_validation_accept_step,
+        &ux_menu_special_validation_reject_step);
+void ui_menu_unlock_batch_validation_display(void) {
+    ux_flow_init(0, ux_flow_unlock_batch_validation, NULL);
+}
+
 /* ONS */
 UX_STEP_NOCB(ux_menu_lns_validation_step, nn, {"Confirm Oxen", "Name Service TX"});
 UX_FLOW(ux_flow_lns_validation,
@@ -292,6 +337,37 @@ void ui_menu_lns_validation_display(void) {
     ux_flow_init(0, ux_flow_lns_validation, NULL);
 }
 
+UX_STEP_NOCB(ux_menu_lns_batch_validation_step, bn, {"ONS Records", G_oxen_state.ux_addr_type});
+UX_FLOW(ux_flow_lns_batch_validation,
+        &ux_menu_lns_batch_validation_step,
+        &ux_menu_special_validation_accept_step,
+        &ux_menu_special_validation_reject_step);
+void ui_menu_lns_batch_validation_display(void) {
+    ux_flow_init(0, ux_flow_lns_batch_validation, NULL);
+}
+
+/* Reserve proof */
+UX_STEP_NOCB(ux_menu_reserve_proof_validation_step, nn, {"Reserve Proof", "Sign key images"});
+UX_FLOW(ux_flow_reserve_proof_validation,
+        &ux_menu_reserve_proof_validation_step,
+        &ux_menu_special_validation_accept_step,
+        &ux_menu_special_validation_reject_step);
+void ui_menu_reserve_proof_validation_display(void) {
+    ux_flow_init(0, ux_flow_reserve_proof_validation, NULL);
+}
+
+/* Message signing */
+UX_STEP_NOCB(ux_menu_sign_message_validation_step,
+             bn,
+             {"Sign Messages", G_oxen_state.ux_addr_type});
+UX_FLOW(ux_flow_sign_message_validation,
+        &ux_menu_sign_message_validation_step,
+        &ux_menu_special_validation_accept_step,
+        &ux_menu_special_validation_reject_step);
+void ui_menu_sign_message_validation_display(void) {
+    ux_flow_init(0, ux_flow_sign_message_validation, NULL);
+}
+
 /* -------------------------------- EXPORT VIEW KEY UX --------------------------------- */
 unsigned int ui_menu_export_viewkey_action(unsigned int value);
 
@@ -562,6 +638,141 @@ void ui_menu_confirm_change_display() {
                             N_oxen_state->confirm_change_mode);
 }
 
+/* --------------------------------- SIGNING POLICY --------------------------------- */
+void ui_menu_policy_action(unsigned int value) {
+    unsigned short sw;
+    if (value == ACCEPT) {
+        oxen_policy_confirmed();
+        sw = SW_OK;
+    } else {
+        memset(G_oxen_state.policy_pending, 0, sizeof(G_oxen_state.policy_pending));
+        sw = SW_DENY;
+    }
+    monero_io_insert_u16(sw);
+    monero_io_do(IO_RETURN_AFTER_TX);
+    ui_menu_main_display();
+}
+OXEN_UX_ACCEPT_REJECT(ux_menu_policy, ui_menu_policy_action);
+
+UX_STEP_NOCB(ux_menu_policy_types_step, bn, {"Policy tx types", G_oxen_state.ux_addr_type});
+UX_STEP_NOCB(ux_menu_policy_max_tx_step, bn, {"Max per tx", G_oxen_state.ux_amount});
+UX_STEP_NOCB(ux_menu_policy_max_fee_step, bn, {"Max fee", G_oxen_state.ux_addr_info});
+UX_STEP_NOCB(ux_menu_policy_budget_step, bn, {"Budget", G_oxen_state.ux_address});
+
+UX_FLOW(ux_flow_policy_caps,
+        &ux_menu_policy_types_step,
+        &ux_menu_policy_max_tx_step,
+        &ux_menu_policy_max_fee_step,
+        &ux_menu_policy_budget_step,
+        &ux_menu_policy_accept_step,
+        &ux_menu_policy_reject_step,
+        FLOW_LOOP);
+
+void ui_menu_policy_caps_display(void) {
+    ux_flow_init(0, ux_flow_policy_caps, NULL);
+}
+
+UX_STEP_NOCB(ux_menu_policy_dest_step,
+             bnnn_paging,
+             {"Allow Recipient", G_oxen_state.ux_address});
+
+UX_FLOW(ux_flow_policy_dest,
+        &ux_menu_policy_dest_step,
+        &ux_menu_policy_accept_step,
+        &ux_menu_policy_reject_step,
+        FLOW_LOOP);
+
+void ui_menu_policy_dest_display(void) {
+    ux_flow_init(0, ux_flow_policy_dest, NULL);
+}
+
+/* --------------------------------- SUBADDRESS TABLE --------------------------------- */
+void ui_menu_subaddr_table_action(unsigned int value) {
+    unsigned short sw;
+    if (value == ACCEPT) {
+        oxen_subaddr_table_confirmed();
+        sw = SW_OK;
+    } else {
+        sw = SW_DENY;
+    }
+    monero_io_insert_u16(sw);
+    monero_io_do(IO_RETURN_AFTER_TX);
+    ui_menu_main_display();
+}
+OXEN_UX_ACCEPT_REJECT(ux_menu_subaddr_table, ui_menu_subaddr_table_action);
+
+UX_STEP_NOCB(ux_menu_subaddr_table_step, bn, {"Subaddr. table", G_oxen_state.ux_amount});
+
+UX_FLOW(ux_flow_subaddr_table,
+        &ux_menu_subaddr_table_step,
+        &ux_menu_subaddr_table_accept_step,
+        &ux_menu_subaddr_table_reject_step,
+        FLOW_LOOP);
+
+void ui_menu_subaddr_table_display(void) {
+    ux_flow_init(0, ux_flow_subaddr_table, NULL);
+}
+
+/* --------------------------------- TX SESSION --------------------------------- */
+void ui_menu_session_action(unsigned int value) {
+    unsigned short sw;
+    if (value == ACCEPT) {
+        sw = oxen_session_confirmed();
+    } else {
+        monero_reset_tx(0);
+        clear_protocol();
+        sw = SW_DENY;
+    }
+    monero_io_insert_u16(sw);
+    monero_io_do(IO_RETURN_AFTER_TX);
+    if (value == ACCEPT)
+        ui_menu_opentx_display(0);
+    else
+        ui_menu_main_display();
+}
+OXEN_UX_ACCEPT_REJECT(ux_menu_session, ui_menu_session_action);
+
+UX_STEP_NOCB(ux_menu_session_cap_step, bn, {"Session cap", G_oxen_state.ux_amount});
+UX_STEP_NOCB(ux_menu_session_dest_step, bnnn_paging, {"Recipient", G_oxen_state.ux_address});
+
+UX_FLOW(ux_flow_session,
+        &ux_menu_session_cap_step,
+        &ux_menu_session_dest_step,
+        &ux_menu_session_accept_step,
+        &ux_menu_session_reject_step,
+        FLOW_LOOP);
+
+void ui_menu_session_display(void) {
+    ux_flow_init(0, ux_flow_session, NULL);
+}
+
+/* -------------------------------- CONFIRM OUTPUTS --------------------------------- */
+
+const char* const confirm_outputs_values[] = {"Each output", "Summary"};
+const char* const confirm_outputs_values_selected[] = {"Each output*", "Summary*"};
+
+const char* confirm_outputs_submenu_getter(unsigned int idx) {
+    if (idx >= ARRAYLEN(confirm_outputs_values)) return NULL;
+    if (N_oxen_state->confirm_outputs_mode == idx) return confirm_outputs_values_selected[idx];
+    return confirm_outputs_values[idx];
+}
+
+void confirm_outputs_submenu_selector(unsigned int idx) {
+    if (idx < ARRAYLEN(confirm_outputs_values)) {
+        unsigned char val = idx;
+        nvm_write((void*) &N_oxen_state->confirm_outputs_mode, &val, sizeof(unsigned char));
+        monero_init();
+    }
+    ui_menu_settings_display_select(UI_SETTINGS_OUTPUTS_CONFIRM);
+}
+
+void ui_menu_confirm_outputs_display() {
+    ux_menulist_init_select(G_ux.stack_count - 1,
+                            confirm_outputs_submenu_getter,
+                            confirm_outputs_submenu_selector,
+                            N_oxen_state->confirm_outputs_mode);
+}
+
 /* -------------------------------- RESET UX --------------------------------- */
 void ui_menu_reset_display(void);
 void ui_menu_reset_action(unsigned int value);
@@ -592,6 +803,7 @@ const char* const settings_submenu_getter_values[] = {
     "Fee confirm",
     "Address confirm",
     "Change confirm",
+    "Outputs confirm",
     "Select Network",
     "Reset",
     "Back",
@@ -618,6 +830,9 @@ void settings_submenu_selector(unsigned int idx) {
         case UI_SETTINGS_CHANGE_CONFIRM:
             ui_menu_confirm_change_display();
             break;
+        case UI_SETTINGS_OUTPUTS_CONFIRM:
+            ui_menu_confirm_outputs_display();
+            break;
         case UI_SETTINGS_SELECT_NETWORK:
             ui_menu_network_display();
             break;
@@ -37,6 +37,11 @@ extern oxen_v_state_t G_oxen_state;
 #define OXEN_TX_STATE_INS_P_EQUALS(ins, p1, p2) \
     (G_oxen_state.tx_state_ins == (ins) && OXEN_TX_STATE_P_EQUALS(p1, p2))
 
+// Fee estimation pass of the wallet: nothing computed for the tx is kept, so the EC work can be
+// replaced with well-formed placeholders.
+#define OXEN_TX_FAKE_MODE() \
+    (G_oxen_state.tx_in_progress && G_oxen_state.tx_sig_mode == TRANSACTION_CREATE_FAKE)
+
 #ifndef TARGET_NANOS
 extern const oxen_nv_state_t N_state_pic;
 #define N_oxen_state ((volatile oxen_nv_state_t *) PIC(&N_state_pic))
@@ -0,0 +1,100 @@
+"""Minimal ed25519 group operations, enough to check device results.
+
+Not constant time: for tests only.
+
+"""
+
+from typing import Optional, Tuple
+
+Q: int = 2**255 - 19
+L: int = 2**252 + 27742317777372353535851937790883648493
+D: int = -121665 * pow(121666, Q - 2, Q) % Q
+SQRT_M1: int = pow(2, (Q - 1) // 4, Q)
+
+# Extended coordinates (X, Y, Z, T) with x = X/Z, y = Y/Z, x*y = T/Z
+Point = Tuple[int, int, int, int]
+
+IDENTITY: Point = (0, 1, 1, 0)
+
+
+def point_add(p: Point, q: Point) -> Point:
+    a = (p[1] - p[0]) * (q[1] - q[0]) % Q
+    b = (p[1] + p[0]) * (q[1] + q[0]) % Q
+    c = 2 * p[3] * q[3] * D % Q
+    d = 2 * p[2] * q[2] % Q
+    e, f, g, h = b - a, d - c, d + c, b + a
+
+    return (e * f % Q, g * h % Q, f * g % Q, e * h % Q)
+
+
+def scalar_mult(k: int, p: Point) -> Point:
+    result: Point = IDENTITY
+    while k > 0:
+        if k & 1:
+            result = point_add(result, p)
+        p = point_add(p, p)
+        k >>= 1
+
+    return result
+
+
+def _recover_x(y: int, sign: int) -> Optional[int]:
+    if y >= Q:
+        return None
+    x2 = (y * y - 1) * pow(D * y * y + 1, Q - 2, Q) % Q
+    if x2 == 0:
+        return None if sign else 0
+    x = pow(x2, (Q + 3) // 8, Q)
+    if (x * x - x2) % Q != 0:
+        x = x * SQRT_M1 % Q
+    if (x * x - x2) % Q != 0:
+        return None
+    if (x & 1) != sign:
+        x = Q - x
+
+    return x
+
+
+def decode_point(value: bytes) -> Point:
+    assert len(value) == 32
+
+    y = int.from_bytes(value, byteorder="little")
+    sign = y >> 255
+    y &= (1 << 255) - 1
+    x = _recover_x(y, sign)
+    if x is None:
+        raise ValueError("Invalid point encoding.")
+
+    return (x, y, 1, x * y % Q)
+
+
+def encode_point(p: Point) -> bytes:
+    zinv = pow(p[2], Q - 2, Q)
+    x, y = p[0] * zinv % Q, p[1] * zinv % Q
+
+    return (y | ((x & 1) << 255)).to_bytes(32, byteorder="little")
+
+
+def decode_scalar(value: bytes) -> int:
+    return int.from_bytes(value, byteorder="little") % L
+
+
+def encode_scalar(k: int) -> bytes:
+    return (k % L).to_bytes(32, byteorder="little")
+
+
+G: Point = decode_point(bytes.fromhex("58666666666666666666666666666666"
+                                      "66666666666666666666666666666666"))
+# Pedersen commitment generator of amounts (rct::H)
+H: Point = decode_point(bytes.fromhex("8b655970153799af2aeadc9ff1add0ea"
+                                      "6c7251d54154cfa92c173a0dd39c1f94"))
+
+
+def mul_base(k: int) -> bytes:
+    return encode_point(scalar_mult(k, G))
+
+
+def commit(amount: int, mask: bytes) -> bytes:
+    """C = amount.H + mask.G"""
+    return encode_point(point_add(scalar_mult(amount, H),
+                                  scalar_mult(decode_scalar(mask), G)))
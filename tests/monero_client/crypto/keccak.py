@@ -0,0 +1,67 @@
+"""Keccak-256 (original padding, as used by Monero's cn_fast_hash).
+
+`hashlib.sha3_256` uses the FIPS 202 padding and gives different results.
+
+"""
+
+from typing import List
+
+ROUND_CONSTANTS: List[int] = [
+    0x0000000000000001, 0x0000000000008082, 0x800000000000808A,
+    0x8000000080008000, 0x000000000000808B, 0x0000000080000001,
+    0x8000000080008081, 0x8000000000008009, 0x000000000000008A,
+    0x0000000000000088, 0x0000000080008009, 0x000000008000000A,
+    0x000000008000808B, 0x800000000000008B, 0x8000000000008089,
+    0x8000000000008003, 0x8000000000008002, 0x8000000000000080,
+    0x000000000000800A, 0x800000008000000A, 0x8000000080008081,
+    0x8000000000008080, 0x0000000080000001, 0x8000000080008008
+]
+
+ROTATIONS: List[List[int]] = [
+    [0, 36, 3, 41, 18],
+    [1, 44, 10, 45, 2],
+    [62, 6, 43, 15, 61],
+    [28, 55, 25, 21, 56],
+    [27, 20, 39, 8, 14]
+]
+
+MASK: int = (1 << 64) - 1
+RATE: int = 136
+
+
+def _rol(x: int, n: int) -> int:
+    return ((x << n) | (x >> (64 - n))) & MASK if n else x
+
+
+def _keccak_f(a: List[List[int]]) -> List[List[int]]:
+    for rc in ROUND_CONSTANTS:
+        c = [a[x][0] ^ a[x][1] ^ a[x][2] ^ a[x][3] ^ a[x][4] for x in range(5)]
+        d = [c[(x - 1) % 5] ^ _rol(c[(x + 1) % 5], 1) for x in range(5)]
+        a = [[a[x][y] ^ d[x] for y in range(5)] for x in range(5)]
+        b = [[0] * 5 for _ in range(5)]
+        for x in range(5):
+            for y in range(5):
+                b[y][(2 * x + 3 * y) % 5] = _rol(a[x][y], ROTATIONS[x][y])
+        a = [[b[x][y] ^ ((~b[(x + 1) % 5][y]) & b[(x + 2) % 5][y])
+              for y in range(5)]
+             for x in range(5)]
+        a[0][0] ^= rc
+
+    return a
+
+
+def keccak256(value: bytes) -> bytes:
+    msg = bytearray(value) + b"\x01"
+    while len(msg) % RATE:
+        msg += b"\x00"
+    msg[-1] |= 0x80
+
+    state = [[0] * 5 for _ in range(5)]
+    for offset in range(0, len(msg), RATE):
+        for i in range(RATE // 8):
+            state[i % 5][i // 5] ^= int.from_bytes(msg[offset + 8 * i:offset + 8 * i + 8],
+                                                   byteorder="little")
+        state = _keccak_f(state)
+
+    return b"".join(state[i % 5][i // 5].to_bytes(8, byteorder="little")
+                    for i in range(4))
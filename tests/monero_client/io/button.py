@@ -1,3 +1,5 @@
+from typing import List, Optional
+
 import requests
 
 
@@ -11,6 +13,13 @@ class FakeButton:
     def both_click(self):
         pass
 
+    def clear_screen(self) -> None:
+        pass
+
+    def screen_texts(self) -> Optional[List[str]]:
+        # nothing is displayed
+        return None
+
 class Button:
     def __init__(self, server: str, port: int) -> None:
         self.server = server
@@ -35,3 +44,19 @@ class Button:
 
         if response.status_code != 200:
             raise Exception(f"Button Request failed with status code {response.status_code}")
+
+    def clear_screen(self) -> None:
+        """Forgets the texts displayed so far."""
+        response = requests.delete(f'http://{self.server}:{self.port}/events')
+
+        if response.status_code != 200:
+            raise Exception(f"Events Request failed with status code {response.status_code}")
+
+    def screen_texts(self) -> Optional[List[str]]:
+        """Texts displayed since the last clear_screen()."""
+        response = requests.get(f'http://{self.server}:{self.port}/events')
+
+        if response.status_code != 200:
+            raise Exception(f"Events Request failed with status code {response.status_code}")
+
+        return [event["text"] for event in response.json()["events"]]
@@ -11,6 +11,10 @@ class Comm(metaclass=ABCMeta):
     def recv(self) -> Tuple[int, bytes]:
         raise NotImplementedError
 
+    def poll(self, timeout: float) -> bool:
+        """Whether a reply comes within timeout seconds, without reading it."""
+        raise NotImplementedError
+
     @abstractmethod
     def exchange(self, apdus: bytes) -> Tuple[int, bytes]:
         raise NotImplementedError
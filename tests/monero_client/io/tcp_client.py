@@ -1,4 +1,5 @@
 import logging
+import select
 import socket
 from typing import Tuple
 
@@ -27,6 +28,11 @@ class TCPClient(Comm):
 
         return sw, data
 
+    def poll(self, timeout: float) -> bool:
+        readable, _, _ = select.select([self.socket], [], [], timeout)
+
+        return bool(readable)
+
     def exchange(self, apdus: bytes) -> Tuple[int, bytes]:
         self.send(apdus)
         sw, response = self.recv()  # type: int, bytes
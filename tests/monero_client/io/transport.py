@@ -51,5 +51,8 @@ class Transport:
     def recv(self) -> Tuple[int, bytes]:
         return self.com.recv()
 
+    def poll(self, timeout: float = 1.0) -> bool:
+        return self.com.poll(timeout)
+
     def close(self) -> None:
         self.com.close()
@@ -18,7 +18,7 @@ abandon abandon abandon abandon abandon about".
 """
 
 import struct
-from typing import Tuple
+from typing import List, Optional, Tuple
 
 from .monero_crypto_cmd import MoneroCryptoCmd
 from .monero_types import InsType, Type, SigType
@@ -62,39 +62,81 @@ class MoneroCmd(MoneroCryptoCmd):
 
         return major, minor, patch
 
-    def set_signature_mode(self, sig_type: SigType) -> int:
-        ins: InsType = InsType.INS_SET_SIGNATURE_MODE
-
-        payload: bytes = struct.pack("B", sig_type)
+    def hello(self, monero_client_version: bytes) -> dict:
+        ins: InsType = InsType.INS_HELLO
 
         self.device.send(cla=PROTOCOL_VERSION,
                          ins=ins,
-                         p1=1,
+                         p1=0,
                          p2=0,
                          option=0,
-                         payload=payload)
+                         payload=monero_client_version)
 
         sw, response = self.device.recv()  # type: int, bytes
 
         if not sw & 0x9000:
-            raise DeviceError(error_code=sw, ins=ins)
+            raise DeviceError(error_code=sw, ins=ins, message="P1=0")
+
+        major, minor, patch, nettype, caps = struct.unpack(">BBBBI", response[:8])
+        view_pub_key, spend_pub_key = response[8:40], response[40:72]
+        offset = 73
+        view_priv_key = None
+        if response[72]:
+            view_priv_key = response[offset:offset + 32]
+            offset += 32
+        address_len = response[offset]
+        address = response[offset + 1:offset + 1 + address_len].decode("ascii")
+        assert len(response) == offset + 1 + address_len
 
-        assert len(response) == 4
+        self.device.send(cla=PROTOCOL_VERSION,
+                         ins=ins,
+                         p1=1,
+                         p2=0,
+                         option=0)
 
-        sig_mode, *_ = struct.unpack(">I", response)
+        sw, prekey = self.device.recv()  # type: int, bytes
 
-        if sig_mode not in (1, 2):
-            raise Exception("Signature mode should be 1 (real) or 2 (fake).")
+        if not sw & 0x9000:
+            raise DeviceError(error_code=sw, ins=ins, message="P1=1")
 
-        return SigType.REAL if sig_mode else SigType.FAKE
+        assert len(prekey) == 200
 
-    def open_tx(self) -> Tuple[bytes, bytes, bytes, bytes]:
-        ins: InsType = InsType.INS_OPEN_TX
+        self.is_in_tx_mode = False
 
-        # 4 bytes
-        version = 4
-        txtype = 0
-        payload: bytes = struct.pack(">HH", version, txtype)
+        return {
+            "version": (major, minor, patch),
+            "nettype": nettype,
+            "capabilities": caps,
+            "view_pub_key": view_pub_key,
+            "spend_pub_key": spend_pub_key,
+            "view_priv_key": view_priv_key,
+            "address": address,
+            "chacha8_prekey": prekey,
+        }
+
+    def reset_network(self, nettype: int) -> None:
+        """Reinstalls the app on another network (debug builds only): this wipes its settings."""
+        ins: InsType = InsType.INS_RESET_NETWORK
+
+        self.device.send(cla=PROTOCOL_VERSION,
+                         ins=ins,
+                         p1=nettype,
+                         p2=0,
+                         option=0)
+
+        sw, response = self.device.recv()  # type: int, bytes
+
+        if not sw & 0x9000:
+            raise DeviceError(error_code=sw, ins=ins)
+
+        assert len(response) == 0
+
+        self.is_in_tx_mode = False
+
+    def set_signature_mode(self, sig_type: SigType) -> int:
+        ins: InsType = InsType.INS_SET_SIGNATURE_MODE
+
+        payload: bytes = struct.pack("B", sig_type)
 
         self.device.send(cla=PROTOCOL_VERSION,
                          ins=ins,
@@ -108,8 +150,17 @@ class MoneroCmd(MoneroCryptoCmd):
         if not sw & 0x9000:
             raise DeviceError(error_code=sw, ins=ins)
 
-        self.is_in_tx_mode = True
+        assert len(response) == 4
+
+        sig_mode, *_ = struct.unpack(">I", response)
+
+        if sig_mode not in (1, 2):
+            raise Exception("Signature mode should be 1 (real) or 2 (fake).")
 
+        return SigType(sig_mode)
+
+    @staticmethod
+    def _tx_keys(response: bytes) -> Tuple[bytes, bytes, bytes, bytes]:
         assert len(response) == 224
 
         tx_pub_key: bytes = response[:32]  # R = r.G
@@ -135,6 +186,93 @@ class MoneroCmd(MoneroCryptoCmd):
                 fake_view_key,
                 fake_spend_key)
 
+    def open_tx(self,
+                button: Optional[Button] = None,
+                session: Optional[Tuple[int, bytes, bytes]] = None,
+                accept: bool = True) -> Tuple[bytes, bytes, bytes, bytes]:
+        ins: InsType = InsType.INS_OPEN_TX
+
+        # 4 bytes
+        version = 4
+        txtype = 0
+        payload: bytes = struct.pack(">HH", version, txtype)
+        # multi-tx session: cap and recipient (A, B) of its outputs
+        if session is not None:
+            cap, dst_pub_view_key, dst_pub_spend_key = session
+            payload += struct.pack(">QB", cap, 0) + dst_pub_view_key + dst_pub_spend_key
+
+        self.device.send(cla=PROTOCOL_VERSION,
+                         ins=ins,
+                         p1=1,
+                         p2=0,
+                         option=0,
+                         payload=payload)
+
+        if session is not None and button is not None:
+            if accept:
+                # "Session cap" -> "Reject" -> "Accept" -> accept
+                button.left_click()
+                button.left_click()
+            else:
+                # "Session cap" -> "Reject" -> reject
+                button.left_click()
+            button.both_click()
+
+        sw, response = self.device.recv()  # type: int, bytes
+
+        if not sw & 0x9000:
+            raise DeviceError(error_code=sw, ins=ins)
+
+        self.is_in_tx_mode = True
+
+        return self._tx_keys(response)
+
+    def open_subtx(self) -> Tuple[bytes, bytes, bytes, bytes]:
+        ins: InsType = InsType.INS_OPEN_TX
+
+        payload: bytes = struct.pack(">HH", 4, 0)
+
+        self.device.send(cla=PROTOCOL_VERSION,
+                         ins=ins,
+                         p1=2,
+                         p2=0,
+                         option=0,
+                         payload=payload)
+
+        sw, response = self.device.recv()  # type: int, bytes
+
+        if not sw & 0x9000:
+            raise DeviceError(error_code=sw, ins=ins, message="P1=2 (sub-tx)")
+
+        return self._tx_keys(response)
+
+    def get_additional_keys(self,
+                            destinations: List[Tuple[bytes, bool]]
+                            ) -> List[bytes]:
+        ins: InsType = InsType.INS_GET_ADDITIONAL_KEY
+
+        payload: bytes = b"".join(
+            (b"\x01" if is_subaddress else b"\x00") + dst_pub_spend_key
+            for dst_pub_spend_key, is_subaddress in destinations
+        )
+
+        self.device.send(cla=PROTOCOL_VERSION,
+                         ins=ins,
+                         p1=0,
+                         p2=0,
+                         option=0,
+                         payload=payload)
+
+        sw, response = self.device.recv()  # type: int, bytes
+
+        if not sw & 0x9000:
+            raise DeviceError(error_code=sw, ins=ins)
+
+        assert len(response) == 32 * len(destinations)
+
+        # additional tx pubkeys: r_i.B_i (subaddress) or r_i.G
+        return [response[i:i + 32] for i in range(0, len(response), 32)]
+
     def close_tx(self) -> None:
         ins: InsType = InsType.INS_CLOSE_TX
 
@@ -219,10 +357,12 @@ class MoneroCmd(MoneroCryptoCmd):
                          option=0,
                          payload=payload)
 
-        # "Timelock" -> go down
-        button.right_click()
-        # "Accept Timelock" -> accept
-        button.both_click()
+        # a timelock has to be confirmed
+        if timelock:
+            # "Timelock" -> go down
+            button.right_click()
+            # "Accept Timelock" -> accept
+            button.both_click()
 
         sw, response = self.device.recv()  # type: int, bytes
 
@@ -311,6 +451,42 @@ class MoneroCmd(MoneroCryptoCmd):
 
         return blinded_mask, blinded_amount
 
+    def blind_batch(self,
+                    _ak_amounts: List[bytes],
+                    amounts: List[int],
+                    page: int = 0) -> List[Tuple[bytes, bytes]]:
+        """Blinds the outputs as one page: the last one (0) unless page says otherwise."""
+        ins: InsType = InsType.INS_BLIND
+
+        payload: bytes = b"".join(
+            b"".join([
+                _ak_amount,
+                hmac_sha256(_ak_amount,
+                            MoneroCryptoCmd.HMAC_KEY,
+                            Type.AMOUNT_KEY),
+                amount.to_bytes(8, byteorder="little")
+            ])
+            for _ak_amount, amount in zip(_ak_amounts, amounts)
+        )
+
+        self.device.send(cla=PROTOCOL_VERSION,
+                         ins=ins,
+                         p1=1,
+                         p2=page,
+                         option=2,  # short amounts only
+                         payload=payload)
+
+        sw, response = self.device.recv()  # type: int, bytes
+
+        if not sw & 0x9000:
+            raise DeviceError(error_code=sw, ins=ins)
+
+        assert len(response) == 40 * len(amounts)
+
+        # (mask, blinded amount) of each output
+        return [(response[i:i + 32], response[i + 32:i + 40])
+                for i in range(0, len(response), 40)]
+
     def unblind(self,
                 _ak_amount: bytes,
                 blinded_mask: bytes,
@@ -346,7 +522,7 @@ class MoneroCmd(MoneroCryptoCmd):
         return mask, amount
 
     def validate_prehash_init(self,
-                              button: Button,
+                              button: Optional[Button],
                               index: int,
                               txntype: int,
                               txnfee: int) -> None:
@@ -362,10 +538,12 @@ class MoneroCmd(MoneroCryptoCmd):
                          option=0,
                          payload=payload)
 
-        # "Fee" -> go down
-        button.right_click()
-        # "Accept Fee" -> accept
-        button.both_click()
+        # no prompt in a fake tx
+        if button is not None:
+            # "Fee" -> go down
+            button.right_click()
+            # "Accept Fee" -> accept
+            button.both_click()
 
         sw, response = self.device.recv()  # type: int, bytes
 
@@ -385,7 +563,9 @@ class MoneroCmd(MoneroCryptoCmd):
                                 commitment: bytes,
                                 blinded_mask: bytes,
                                 blinded_amount: bytes,
-                                is_last: bool) -> None:
+                                is_last: bool,
+                                wait: bool = True) -> None:
+        """Sends an output; with wait=False, validate_prehash_update_reply() gets the reply."""
         ins: InsType = InsType.INS_VALIDATE
 
         payload: bytes = b"".join((
@@ -409,6 +589,13 @@ class MoneroCmd(MoneroCryptoCmd):
                          option=(0 if is_last else 0x80) | (0x02 if is_short else 0),
                          payload=payload)
 
+        if wait:
+            self.validate_prehash_update_reply()
+
+    def validate_prehash_update_reply(self) -> None:
+        ins: InsType = InsType.INS_VALIDATE
+
+        # held while the prompt of a previous output is on screen
         sw, response = self.device.recv()  # type: int, bytes
 
         if not sw & 0x9000:
@@ -416,44 +603,144 @@ class MoneroCmd(MoneroCryptoCmd):
 
         assert len(response) == 0
 
+    def reply_pending(self, timeout: float = 1.0) -> bool:
+        return self.device.poll(timeout)
+
     def validate_prehash_finalize(self,
+                                  button: Optional[Button],
                                   index: int,
-                                  is_short: bool,
-                                  is_change_addr: bool,
-                                  is_subaddress: bool,
-                                  dst_pub_view_key: bytes,
-                                  dst_pub_spend_key: bytes,
-                                  _ak_amount: bytes,
-                                  commitment: bytes,
-                                  blinded_mask: bytes,
-                                  blinded_amount: bytes,
-                                  is_last: bool) -> None:
+                                  commitments: List[bytes],
+                                  message: bytes,
+                                  proof: bytes,
+                                  accept: bool = True) -> bytes:
         ins: InsType = InsType.INS_VALIDATE
 
-        payload: bytes = b"".join((
-            b"\x01" if is_subaddress else b"\x00",
-            b"\x01" if is_change_addr else b"\x00",
-            dst_pub_view_key,
-            dst_pub_spend_key,
-            _ak_amount,
-            hmac_sha256(_ak_amount,
-                        MoneroCryptoCmd.HMAC_KEY,
-                        Type.AMOUNT_KEY),
-            commitment,
-            blinded_mask,
-            blinded_amount
-        ))
+        # one command per output commitment, then the last one with the prefix hash
+        for i, commitment in enumerate(commitments):
+            self.device.send(cla=PROTOCOL_VERSION,
+                             ins=ins,
+                             p1=3,
+                             p2=index + i,
+                             option=0x80,
+                             payload=commitment)
+
+            sw, response = self.device.recv()  # type: int, bytes
+
+            if not sw & 0x9000:
+                raise DeviceError(error_code=sw, ins=ins, message="P1=3 (finalize)")
+
+            assert len(response) == 0
 
         self.device.send(cla=PROTOCOL_VERSION,
                          ins=ins,
                          p1=3,
+                         p2=index + len(commitments),
+                         option=0,
+                         payload=message + proof)
+
+        # The reply is held while the prompt of the last output is on screen
+        if button is not None:
+            if accept:
+                # "Confirm Amount" -> "Reject" -> "Accept" -> accept
+                button.left_click()
+                button.left_click()
+            else:
+                # "Confirm Amount" -> "Reject" -> reject
+                button.left_click()
+            button.both_click()
+
+        sw, response = self.device.recv()  # type: int, bytes
+
+        if not sw & 0x9000:
+            raise DeviceError(error_code=sw, ins=ins, message="P1=3 (finalize)")
+
+        assert len(response) == 32
+
+        return response  # pre-CLSAG hash
+
+    def clsag_prepare_slot(self,
+                           _p: bytes,
+                           z: bytes,
+                           H: bytes) -> Tuple[bytes, bytes, bytes, bytes]:
+        ins: InsType = InsType.INS_CLSAG
+
+        payload: bytes = b"".join([
+            _p,
+            hmac_sha256(_p,
+                        MoneroCryptoCmd.HMAC_KEY,
+                        Type.SCALAR),
+            z,
+            H
+        ])
+
+        self.device.send(cla=PROTOCOL_VERSION,
+                         ins=ins,
+                         p1=4,
+                         p2=0,
+                         option=0,
+                         payload=payload)
+
+        sw, response = self.device.recv()  # type: int, bytes
+
+        if not sw & 0x9000:
+            raise DeviceError(error_code=sw, ins=ins, message="P1=4 (prepare slot)")
+
+        assert len(response) == 128
+
+        # a.G, a.H, I = p.H, D = z.H
+        return response[:32], response[32:64], response[64:96], response[96:]
+
+    def clsag_hash(self, data: bytes) -> bytes:
+        ins: InsType = InsType.INS_CLSAG
+
+        self.device.send(cla=PROTOCOL_VERSION,
+                         ins=ins,
+                         p1=2,
+                         p2=0,
+                         option=0,
+                         payload=data)
+
+        sw, response = self.device.recv()  # type: int, bytes
+
+        if not sw & 0x9000:
+            raise DeviceError(error_code=sw, ins=ins, message="P1=2 (hash)")
+
+        assert len(response) == 32
+
+        return response  # c
+
+    def clsag_sign_page(self,
+                        index: int,
+                        entries: List[Tuple[bytes, bytes]]) -> List[bytes]:
+        ins: InsType = InsType.INS_CLSAG
+
+        payload: bytes = b"".join(mu_P + mu_C for mu_P, mu_C in entries)
+
+        self.device.send(cla=PROTOCOL_VERSION,
+                         ins=ins,
+                         p1=5,
                          p2=index,
-                         option=(0 if is_last else 0x80) | (0x02 if is_short else 0),
+                         option=0,
                          payload=payload)
 
         sw, response = self.device.recv()  # type: int, bytes
 
         if not sw & 0x9000:
-            raise DeviceError(error_code=sw, ins=ins, message="P1=3 (finalize)")
+            raise DeviceError(error_code=sw, ins=ins, message="P1=5 (sign slots)")
 
-        assert len(response) == 0
+        assert len(response) == 32 * len(entries)
+
+        # s of each slot
+        return [response[i:i + 32] for i in range(0, len(response), 32)]
+
+    def clsag_sign_slots(self,
+                         entries: List[Tuple[bytes, bytes]],
+                         page_size: int = 3) -> List[bytes]:
+        pages = [entries[i:i + page_size] for i in range(0, len(entries), page_size)]
+
+        signatures: List[bytes] = []
+        for i, page in enumerate(pages):
+            # [5,1], [5,2], ... and [5,0] for the last page
+            signatures += self.clsag_sign_page(0 if i == len(pages) - 1 else i + 1, page)
+
+        return signatures
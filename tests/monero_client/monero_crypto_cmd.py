@@ -1,5 +1,5 @@
 import struct
-from typing import Tuple
+from typing import List, Optional, Tuple
 
 from .crypto.hmac import hmac_sha256
 from .exception.device_error import DeviceError
@@ -94,11 +94,12 @@ class MoneroCryptoCmd:
         if not sw & 0x9000:
             raise DeviceError(sw, ins, "P1=1")
 
-        assert len(response) == 161
+        # a mainnet address has a one byte prefix, the others two
+        assert len(response) in (64 + 95, 64 + 97)
 
         view_pub_key = response[:32]
         spend_pub_key = response[32:64]
-        base58_address = response[64:161].decode("ascii")
+        base58_address = response[64:].decode("ascii")
 
         return view_pub_key, spend_pub_key, base58_address
 
@@ -124,6 +125,27 @@ class MoneroCryptoCmd:
 
         return response  # priv_view_key
 
+    def get_derivation_cache_stats(self) -> Tuple[int, int]:
+        """Hits and misses of the key derivation cache (debug builds only)."""
+        ins: InsType = InsType.INS_GET_KEY
+
+        self.device.send(cla=PROTOCOL_VERSION,
+                         ins=ins,
+                         p1=5,
+                         p2=0,
+                         option=0)
+
+        sw, response = self.device.recv()  # type: int, bytes
+
+        if not sw & 0x9000:
+            raise DeviceError(sw, ins, "P1=5")
+
+        assert len(response) == 8
+
+        hits, misses = struct.unpack(">II", response)  # type: int, int
+
+        return hits, misses
+
     def generate_keypair(self) -> Tuple[bytes, bytes]:
         ins: InsType = InsType.INS_GENERATE_KEYPAIR
 
@@ -194,6 +216,37 @@ class MoneroCryptoCmd:
 
         return response  # key image
 
+    def generate_key_image_signature(self,
+                                     image: bytes,
+                                     _priv_key: bytes,
+                                     pub_key: bytes) -> bytes:
+        ins: InsType = InsType.INS_GEN_KEY_IMAGE_SIGNATURE
+
+        payload: bytes = b"".join([
+            image,
+            pub_key,
+            _priv_key,
+            hmac_sha256(_priv_key,
+                        MoneroCryptoCmd.HMAC_KEY,
+                        Type.SCALAR),  # hmac
+        ])
+
+        self.device.send(cla=PROTOCOL_VERSION,
+                         ins=ins,
+                         p1=0,
+                         p2=0,
+                         option=0,
+                         payload=payload)
+
+        sw, response = self.device.recv()  # type: int, bytes
+
+        if not sw & 0x9000:
+            raise DeviceError(sw, ins)
+
+        assert len(response) == 64
+
+        return response  # c || r
+
     def put_key(self,
                 priv_view_key: bytes,
                 pub_view_key: bytes,
@@ -261,6 +314,37 @@ class MoneroCryptoCmd:
 
         return _d_in
 
+    def encrypt_payment_id(self,
+                           pub_key: bytes,
+                           _priv_key: bytes,
+                           payment_id: bytes) -> bytes:
+        ins: InsType = InsType.INS_STEALTH
+
+        payload: bytes = b"".join([
+            pub_key,
+            _priv_key,
+            hmac_sha256(_priv_key,
+                        MoneroCryptoCmd.HMAC_KEY,
+                        Type.SCALAR),
+            payment_id
+        ])
+
+        self.device.send(cla=PROTOCOL_VERSION,
+                         ins=ins,
+                         p1=0,
+                         p2=0,
+                         option=0,
+                         payload=payload)
+
+        sw, response = self.device.recv()  # type: int, bytes
+
+        if not sw & 0x9000:
+            raise DeviceError(sw, ins)
+
+        assert len(response) == 8
+
+        return response  # encrypted payment id
+
     def generate_unlock_signature(self, button, _priv_key: bytes, pub_key: bytes) -> bytes:
         ins: InsType = InsType.INS_GEN_UNLOCK_SIGNATURE
         self.device.send(cla=PROTOCOL_VERSION,
@@ -305,6 +389,54 @@ class MoneroCryptoCmd:
 
         return response  # signature
 
+    def generate_unlock_signatures(self,
+                                   button,
+                                   keys: List[Tuple[bytes, bytes]],
+                                   count: Optional[int] = None) -> List[bytes]:
+        """Signs the unlocks of keys, after confirming count of them (all by default)."""
+        ins: InsType = InsType.INS_GEN_UNLOCK_SIGNATURE
+        self.device.send(cla=PROTOCOL_VERSION,
+                         ins=ins,
+                         p1=0,
+                         p2=len(keys) if count is None else count,
+                         option=0,
+                         payload=b"")
+
+        # Click accept unlock
+        button.right_click()
+        button.both_click()
+        sw, response = self.device.recv()  # type: int, bytes
+
+        if not sw & 0x9000:
+            raise DeviceError(sw, ins)
+
+        assert len(response) == 0
+
+        signatures: List[bytes] = []
+        for i in range(0, len(keys), 2):
+            payload: bytes = b"".join(
+                pub_key + _priv_key + hmac_sha256(_priv_key,
+                                                  MoneroCryptoCmd.HMAC_KEY,
+                                                  Type.SCALAR)
+                for _priv_key, pub_key in keys[i:i + 2])
+
+            self.device.send(cla=PROTOCOL_VERSION,
+                             ins=ins,
+                             p1=1,
+                             p2=i // 2 + 1,
+                             option=0,
+                             payload=payload)
+
+            sw, response = self.device.recv()  # type: int, bytes
+
+            if not sw & 0x9000:
+                raise DeviceError(sw, ins)
+
+            assert len(response) == 64 * len(keys[i:i + 2])
+            signatures += [response[j:j + 64] for j in range(0, len(response), 64)]
+
+        return signatures
+
     def generate_ons_signature(self, button, name) -> bytes:
         ins: InsType = InsType.INS_GEN_LNS_SIGNATURE
         self.device.send(cla=PROTOCOL_VERSION,
@@ -357,3 +489,377 @@ class MoneroCryptoCmd:
         assert len(response) == 64
 
         return response  # signature
+
+    def generate_ons_signatures(self,
+                                button,
+                                records: List[Tuple[str, int, int]],
+                                count: Optional[int] = None) -> List[bytes]:
+        """Signs the ONS records, after confirming count of them (all by default)."""
+        ins: InsType = InsType.INS_GEN_LNS_SIGNATURE
+        self.device.send(cla=PROTOCOL_VERSION,
+                         ins=ins,
+                         p1=0,
+                         p2=len(records) if count is None else count,
+                         option=0,
+                         payload=b"")
+
+        # Click accept ONS records
+        button.right_click()
+        button.both_click()
+        sw, response = self.device.recv()  # type: int, bytes
+
+        if not sw & 0x9000:
+            raise DeviceError(sw, ins)
+
+        assert len(response) == 0
+
+        signatures: List[bytes] = []
+        for name, major, minor in records:
+            self.device.send(cla=PROTOCOL_VERSION,
+                             ins=ins,
+                             p1=1,
+                             p2=0,
+                             option=0,
+                             payload=name.encode())
+            sw, response = self.device.recv()  # type: int, bytes
+
+            if not sw & 0x9000:
+                raise DeviceError(sw, ins)
+
+            assert len(response) == 0
+
+            self.device.send(cla=PROTOCOL_VERSION,
+                             ins=ins,
+                             p1=2,
+                             p2=0,
+                             option=0,
+                             payload=struct.pack("<II", major, minor))
+            sw, response = self.device.recv()  # type: int, bytes
+
+            if not sw & 0x9000:
+                raise DeviceError(sw, ins)
+
+            assert len(response) == 64
+            signatures.append(response)
+
+        return signatures
+
+    def get_tx_proofs(self,
+                      msg: bytes,
+                      A: bytes,
+                      B: bytes,
+                      entries: List[Tuple[bytes, bytes, bytes]],
+                      subaddress: bool = False,
+                      v2: bool = False) -> List[Tuple[bytes, bytes]]:
+        ins: InsType = InsType.INS_GET_TX_PROOF
+        self.device.send(cla=PROTOCOL_VERSION,
+                         ins=ins,
+                         p1=1,
+                         p2=0,
+                         option=(1 if subaddress else 0) | (2 if v2 else 0),
+                         payload=msg + A + B)
+        sw, response = self.device.recv()  # type: int, bytes
+
+        if not sw & 0x9000:
+            raise DeviceError(sw, ins)
+
+        assert len(response) == 0
+
+        # V2 entries carry R as well, so only one fits in a command
+        step: int = 1 if v2 else 2
+        proofs: List[Tuple[bytes, bytes]] = []
+        for i in range(0, len(entries), step):
+            payload: bytes = b"".join(
+                (R if v2 else b"") + D + _priv_key + hmac_sha256(_priv_key,
+                                                                 MoneroCryptoCmd.HMAC_KEY,
+                                                                 Type.SCALAR)
+                for R, D, _priv_key in entries[i:i + step])
+
+            self.device.send(cla=PROTOCOL_VERSION,
+                             ins=ins,
+                             p1=2,
+                             p2=0,
+                             option=0,
+                             payload=payload)
+            sw, response = self.device.recv()  # type: int, bytes
+
+            if not sw & 0x9000:
+                raise DeviceError(sw, ins)
+
+            assert len(response) == 64 * len(entries[i:i + step])
+            proofs += [(response[j:j + 32], response[j + 32:j + 64])
+                       for j in range(0, len(response), 64)]
+
+        return proofs
+
+    def reserve_proof_start(self, button) -> None:
+        ins: InsType = InsType.INS_RESERVE_PROOF
+        self.device.send(cla=PROTOCOL_VERSION,
+                         ins=ins,
+                         p1=0,
+                         p2=0,
+                         option=0,
+                         payload=b"")
+
+        # Click accept reserve proof
+        button.right_click()
+        button.both_click()
+        sw, response = self.device.recv()  # type: int, bytes
+
+        if not sw & 0x9000:
+            raise DeviceError(sw, ins)
+
+        assert len(response) == 0
+
+    def reserve_proof_entries(self,
+                              entries: List[Tuple[bytes, int, int, int, bytes]]
+                              ) -> List[Tuple[bytes, bytes]]:
+        ins: InsType = InsType.INS_RESERVE_PROOF
+        signed: List[Tuple[bytes, bytes]] = []
+        for i in range(0, len(entries), 2):
+            payload: bytes = b"".join(
+                R + struct.pack(">I", out_idx) + struct.pack("<II", major, minor) + P
+                for R, out_idx, major, minor, P in entries[i:i + 2])
+
+            self.device.send(cla=PROTOCOL_VERSION,
+                             ins=ins,
+                             p1=1,
+                             p2=0,
+                             option=0,
+                             payload=payload)
+            sw, response = self.device.recv()  # type: int, bytes
+
+            if not sw & 0x9000:
+                raise DeviceError(sw, ins)
+
+            assert len(response) == 96 * len(entries[i:i + 2])
+            signed += [(response[j:j + 32], response[j + 32:j + 96])
+                       for j in range(0, len(response), 96)]
+
+        return signed
+
+    def reserve_proof_finish(self) -> Tuple[int, bytes]:
+        ins: InsType = InsType.INS_RESERVE_PROOF
+        self.device.send(cla=PROTOCOL_VERSION,
+                         ins=ins,
+                         p1=2,
+                         p2=0,
+                         option=0,
+                         payload=b"")
+        sw, response = self.device.recv()  # type: int, bytes
+
+        if not sw & 0x9000:
+            raise DeviceError(sw, ins)
+
+        assert len(response) == 4 + 32
+
+        return struct.unpack(">I", response[:4])[0], response[4:]
+
+    def sign_messages(self,
+                      button,
+                      messages: List[Tuple[bytes, int, int]]) -> List[bytes]:
+        ins: InsType = InsType.INS_SIGN_MESSAGE
+        self.device.send(cla=PROTOCOL_VERSION,
+                         ins=ins,
+                         p1=0,
+                         p2=len(messages),
+                         option=0,
+                         payload=b"")
+
+        # Click accept messages
+        button.right_click()
+        button.both_click()
+        sw, response = self.device.recv()  # type: int, bytes
+
+        if not sw & 0x9000:
+            raise DeviceError(sw, ins)
+
+        assert len(response) == 0
+
+        signatures: List[bytes] = []
+        for message, major, minor in messages:
+            self.device.send(cla=PROTOCOL_VERSION,
+                             ins=ins,
+                             p1=1,
+                             p2=0,
+                             option=0,
+                             payload=message)
+            sw, response = self.device.recv()  # type: int, bytes
+
+            if not sw & 0x9000:
+                raise DeviceError(sw, ins)
+
+            assert len(response) == 0
+
+            self.device.send(cla=PROTOCOL_VERSION,
+                             ins=ins,
+                             p1=2,
+                             p2=0,
+                             option=0,
+                             payload=struct.pack("<II", major, minor))
+            sw, response = self.device.recv()  # type: int, bytes
+
+            if not sw & 0x9000:
+                raise DeviceError(sw, ins)
+
+            assert len(response) == 64
+            signatures.append(response)
+
+        return signatures
+
+    def get_subaddress(self, major: int, minor: int) -> Tuple[bytes, bytes]:
+        ins: InsType = InsType.INS_GET_SUBADDRESS
+
+        self.device.send(cla=PROTOCOL_VERSION,
+                         ins=ins,
+                         p1=0,
+                         p2=0,
+                         option=0,
+                         payload=struct.pack("<II", major, minor))
+
+        sw, response = self.device.recv()  # type: int, bytes
+
+        if not sw & 0x9000:
+            raise DeviceError(sw, ins)
+
+        assert len(response) == 64
+
+        return response[:32], response[32:]  # C, D
+
+    def set_subaddress_table(self,
+                             button,
+                             majors: int,
+                             minors: int,
+                             accept: bool = True) -> None:
+        ins: InsType = InsType.INS_SUBADDRESS_TABLE
+
+        self.device.send(cla=PROTOCOL_VERSION,
+                         ins=ins,
+                         p1=1,
+                         p2=0,
+                         option=0,
+                         payload=struct.pack("BB", majors, minors))
+
+        if button is not None:
+            # the flow loops: Reject is left of the size, Accept left of Reject
+            button.left_click()
+            if accept:
+                button.left_click()
+            button.both_click()
+        sw, response = self.device.recv()  # type: int, bytes
+
+        if not sw & 0x9000:
+            raise DeviceError(sw, ins, "P1=1")
+
+        assert len(response) == 0
+
+    def build_subaddress_table(self) -> int:
+        ins: InsType = InsType.INS_SUBADDRESS_TABLE
+
+        self.device.send(cla=PROTOCOL_VERSION,
+                         ins=ins,
+                         p1=2,
+                         p2=0,
+                         option=0)
+
+        sw, response = self.device.recv()  # type: int, bytes
+
+        if not sw & 0x9000:
+            raise DeviceError(sw, ins, "P1=2")
+
+        assert len(response) == 2
+
+        return int.from_bytes(response, byteorder="big")  # entries still missing
+
+    def disable_subaddress_table(self) -> None:
+        ins: InsType = InsType.INS_SUBADDRESS_TABLE
+
+        self.device.send(cla=PROTOCOL_VERSION,
+                         ins=ins,
+                         p1=0,
+                         p2=0,
+                         option=0)
+
+        sw, response = self.device.recv()  # type: int, bytes
+
+        if not sw & 0x9000:
+            raise DeviceError(sw, ins, "P1=0")
+
+        assert len(response) == 0
+
+    def set_policy(self,
+                   button,
+                   tx_types: int,
+                   max_tx_amount: int,
+                   max_fee: int,
+                   budget: int,
+                   accept: bool = True) -> None:
+        ins: InsType = InsType.INS_SET_POLICY
+
+        payload: bytes = struct.pack(">BQQQ", tx_types, max_tx_amount, max_fee, budget)
+
+        self.device.send(cla=PROTOCOL_VERSION,
+                         ins=ins,
+                         p1=1,
+                         p2=0,
+                         option=0,
+                         payload=payload)
+
+        # types, max per tx, max fee, budget, then accept (or one more for reject)
+        for _ in range(4 if accept else 5):
+            button.right_click()
+        button.both_click()
+        sw, response = self.device.recv()  # type: int, bytes
+
+        if not sw & 0x9000:
+            raise DeviceError(sw, ins)
+
+        assert len(response) == 0
+
+    def add_policy_dest(self,
+                        button,
+                        dst_pub_view_key: bytes,
+                        dst_pub_spend_key: bytes,
+                        is_subaddress: bool = False,
+                        accept: bool = True) -> None:
+        ins: InsType = InsType.INS_SET_POLICY
+
+        payload: bytes = (struct.pack(">B", is_subaddress) +
+                          dst_pub_view_key +
+                          dst_pub_spend_key)
+
+        self.device.send(cla=PROTOCOL_VERSION,
+                         ins=ins,
+                         p1=2,
+                         p2=0,
+                         option=0,
+                         payload=payload)
+
+        # the flow loops: Reject is left of the recipient, Accept left of Reject
+        button.left_click()
+        if accept:
+            button.left_click()
+        button.both_click()
+        sw, response = self.device.recv()  # type: int, bytes
+
+        if not sw & 0x9000:
+            raise DeviceError(sw, ins)
+
+        assert len(response) == 0
+
+    def clear_policy(self) -> None:
+        ins: InsType = InsType.INS_SET_POLICY
+
+        self.device.send(cla=PROTOCOL_VERSION,
+                         ins=ins,
+                         p1=0,
+                         p2=0,
+                         option=0,
+                         payload=b"")
+
+        sw, response = self.device.recv()  # type: int, bytes
+
+        if not sw & 0x9000:
+            raise DeviceError(sw, ins)
+
+        assert len(response) == 0
@@ -31,6 +31,9 @@ class InsType(enum.IntEnum):
     INS_NONE = 0x00
     INS_RESET = 0x02
     INS_LOCK_DISPLAY = 0x04
+    INS_HELLO = 0x06
+    INS_GET_NETWORK = 0x10
+    INS_RESET_NETWORK = 0x11
 
     INS_GET_KEY = 0x20
     INS_DISPLAY_ADDRESS = 0x21
@@ -53,6 +56,7 @@ class InsType(enum.IntEnum):
     INS_GET_SUBADDRESS = 0x48
     INS_GET_SUBADDRESS_SPEND_PUBLIC_KEY = 0x4A
     INS_GET_SUBADDRESS_SECRET_KEY = 0x4C
+    INS_SUBADDRESS_TABLE = 0x4E
 
     INS_OPEN_TX = 0x70
     INS_SET_SIGNATURE_MODE = 0x72
@@ -68,10 +72,14 @@ class InsType(enum.IntEnum):
     INS_CLSAG = 0x7F
     INS_CLOSE_TX = 0x80
 
+    INS_SET_POLICY = 0x90
+
     INS_GET_TX_PROOF = 0xA0
     INS_GEN_UNLOCK_SIGNATURE =  0xA2
     INS_GEN_LNS_SIGNATURE    =  0xA3
-    INS_GEN_RING_SIGNATURE = 0xA4
+    INS_GEN_KEY_IMAGE_SIGNATURE = 0xA4
+    INS_RESERVE_PROOF = 0xA5
+    INS_SIGN_MESSAGE = 0xA6
 
     INS_GET_RESPONSE = 0xc0
 
@@ -1,3 +1,18 @@
+import hashlib
+import struct
+from typing import List, Tuple
+
+import pytest
+
+from monero_client.crypto.ed25519 import (G, L, decode_point, decode_scalar, encode_point,
+                                          encode_scalar, point_add, scalar_mult)
+from monero_client.crypto.keccak import keccak256
+from monero_client.monero_types import SigType
+from monero_client.exception import (CommandNotAllowed, Deny, SecurityLocked, WrongData,
+                                     WrongDataRange)
+from monero_client.utils.base58 import encode as base58_encode
+from monero_client.utils.varint import encode_varint
+
 OXEN_VIEW_PUB_KEY    = "ed26f4f9ed44baccb0aa32bfd91fd546115a60c77e6e8098cd4debf8f33cb9f9"
 OXEN_SPEND_PUB_KEY   = "9834c238ebecb78b1f30115c50b956e9e5e0d86072c61d57e65ee04f9c650b40"
 OXEN_VIEW_PRIV_KEY   = "5f51194e0f839ee32fdd85765be009b1fceb70e78204e4bfa3010e2ade61fc0d"
@@ -66,13 +81,380 @@ def test_gen_key_derivation(monero):
 
     assert expected_key_derivation == key_derivation # decrypt _d_in
 
+def key_derivation(_priv_key: bytes, pub_key: bytes) -> bytes:
+    """8.r.P, encrypted like the device does (r is encrypted as well)"""
+    r: int = decode_scalar(bytes(byte ^ 0x55 for byte in _priv_key))
+    derivation: bytes = encode_point(scalar_mult(8 * r % L, decode_point(pub_key)))
+
+    return bytes(byte ^ 0x55 for byte in derivation)
+
+def test_derivation_cache(monero):
+    pub_key: bytes = bytes.fromhex(OXEN_VIEW_PUB_KEY)
+    (r0, _), (r1, _) = stake_keys(monero, 2)
+
+    monero.reset_and_get_version(b"10.0.0")
+    hits, misses = monero.get_derivation_cache_stats()
+    assert monero.gen_key_derivation(pub_key=pub_key, _priv_key=r0) == key_derivation(r0, pub_key)
+    assert monero.get_derivation_cache_stats() == (hits, misses + 1)
+    # the same pair again: from the cache
+    assert monero.gen_key_derivation(pub_key=pub_key, _priv_key=r0) == key_derivation(r0, pub_key)
+    assert monero.get_derivation_cache_stats() == (hits + 1, misses + 1)
+    # another scalar for the same point is not taken for it
+    assert monero.gen_key_derivation(pub_key=pub_key, _priv_key=r1) == key_derivation(r1, pub_key)
+    assert monero.get_derivation_cache_stats() == (hits + 1, misses + 2)
+
+    # A tx renews the key of the tags, so what was cached before is derived again
+    assert monero.set_signature_mode(sig_type=SigType.REAL) == SigType.REAL
+    monero.open_tx()
+    hits, misses = monero.get_derivation_cache_stats()
+    assert monero.gen_key_derivation(pub_key=pub_key, _priv_key=r0) == key_derivation(r0, pub_key)
+    assert monero.get_derivation_cache_stats() == (hits, misses + 1)
+    assert monero.gen_key_derivation(pub_key=pub_key, _priv_key=r0) == key_derivation(r0, pub_key)
+    assert monero.get_derivation_cache_stats() == (hits + 1, misses + 1)
+    monero.reset_and_get_version(b"10.0.0")
+
+STAKE_UNLOCK_HASH: bytes = b"UNLK" * 8
+
 def test_unlock_signature(monero, button):
     _priv_key: bytes = bytes.fromhex("38306180e44a3ca14f4f18b505bce76330a7b03df8c8611ac9bd4ed70c6ce454")
     pub_key: bytes = bytes.fromhex("3cad24457b5b505674af0296976ea36baeab28407bc6f4441ee220aa78900296")
 
-    monero.generate_unlock_signature(button, _priv_key=_priv_key, pub_key=pub_key)
+    signature: bytes = monero.generate_unlock_signature(button, _priv_key=_priv_key, pub_key=pub_key)
+    assert signature_valid(signature, STAKE_UNLOCK_HASH, pub_key)
     monero.reset_and_get_version(b"10.0.0")
 
+def stake_keys(monero, n: int) -> List[Tuple[bytes, bytes]]:
+    """(encrypted secret, public) key pairs of n different stakes"""
+    keys: List[Tuple[bytes, bytes]] = []
+    for i in range(n):
+        x: int = decode_scalar(keccak256(b"stake" + bytes([i])))
+        keys.append((monero.xor_cipher(encode_scalar(x), b"\x55"), encode_point(scalar_mult(x, G))))
+
+    return keys
+
+def test_batch_unlock_signature(monero, button):
+    keys = stake_keys(monero, 3)
+
+    signatures = monero.generate_unlock_signatures(button, keys)
+    assert len(signatures) == 3
+    for (_, pub_key), signature in zip(keys, signatures):
+        assert signature_valid(signature, STAKE_UNLOCK_HASH, pub_key)
+    monero.reset_and_get_version(b"10.0.0")
+
+    # A page past the confirmed count locks the device
+    with pytest.raises(WrongData):
+        monero.generate_unlock_signatures(button, keys, count=2)
+    with pytest.raises(SecurityLocked):
+        monero.reset_and_get_version(b"10.0.0")
+    # "Security Err" -> PIN lock, which lets the next command in again
+    button.both_click()
+    monero.reset_and_get_version(b"10.0.0")
+
+def ons_hash(name: str) -> bytes:
+    return hashlib.blake2b(name.encode(), digest_size=32).digest()
+
 def test_ons_signature(monero, button):
-    monero.generate_ons_signature(button, name="hello")
+    signature: bytes = monero.generate_ons_signature(button, name="hello")
+    assert signature_valid(signature, ons_hash("hello"), subaddress(0, 0)[1])
+    monero.reset_and_get_version(b"10.0.0")
+
+def test_batch_ons_signature(monero, button):
+    records = [("hello", 0, 0), ("world", 0, 1), ("again", 0, 1)]
+
+    signatures = monero.generate_ons_signatures(button, records)
+    assert len(signatures) == 3
+    # each record hash, signed with the spend key of its subaddress
+    for (name, major, minor), signature in zip(records, signatures):
+        assert signature_valid(signature, ons_hash(name), subaddress(major, minor)[1])
+    monero.reset_and_get_version(b"10.0.0")
+
+    # One record more than confirmed is refused
+    with pytest.raises(CommandNotAllowed):
+        monero.generate_ons_signatures(button, records, count=2)
+    monero.reset_and_get_version(b"10.0.0")
+
+def test_warm_reset(monero, button):
+    # RESET keeps the derived keys: every use of them gives the same results as before
+    for _ in range(3):
+        monero.reset_and_get_version(b"10.0.0")
+        view_pub_key, spend_pub_key, address = monero.get_public_keys()  # type: bytes, bytes, str
+        assert view_pub_key == bytes.fromhex(OXEN_VIEW_PUB_KEY)
+        assert spend_pub_key == bytes.fromhex(OXEN_SPEND_PUB_KEY)
+        assert address == OXEN_TESTNET_ADDRESS
+        # the view key
+        assert monero.get_subaddress(1, 2) == subaddress(1, 2)
+        # the spend key
+        signature: bytes = monero.generate_ons_signature(button, name="warm")
+        assert signature_valid(signature, ons_hash("warm"), spend_pub_key)
+    monero.reset_and_get_version(b"10.0.0")
+
+def test_batch_tx_proof(monero):
+    _priv_key: bytes = bytes.fromhex("38306180e44a3ca14f4f18b505bce76330a7b03df8c8611ac9bd4ed70c6ce454")
+    pub_key: bytes = bytes.fromhex("3cad24457b5b505674af0296976ea36baeab28407bc6f4441ee220aa78900296")
+    msg: bytes = bytes(range(32))
+
+    entries = [(pub_key, pub_key, _priv_key)] * 3
+
+    proofs = monero.get_tx_proofs(msg, A=pub_key, B=pub_key, entries=entries)
+    assert len(proofs) == 3
+    # Fresh nonce for each proof
+    assert len(set(proofs)) == 3
+
+    proofs = monero.get_tx_proofs(msg, A=pub_key, B=pub_key, entries=entries, v2=True)
+    assert len(proofs) == 3
+    monero.reset_and_get_version(b"10.0.0")
+
+def owned_output(r: int, out_idx: int, major: int, minor: int) -> Tuple[bytes, bytes, int]:
+    """R, output key P and its secret key x of output out_idx of a tx (key r) to a subaddress"""
+    view_priv: bytes = bytes.fromhex(OXEN_VIEW_PRIV_KEY)
+    x: int = decode_scalar(bytes.fromhex(OXEN_SPEND_PRIV_KEY))
+    if major == 0 and minor == 0:
+        R = scalar_mult(r, G)
+    else:
+        x += decode_scalar(keccak256(b"SubAddr\x00" + view_priv + struct.pack("<II", major, minor)))
+        R = scalar_mult(r, decode_point(subaddress(major, minor)[1]))
+
+    # x = H_s(8aR || out_idx) + b (+ m)
+    derivation: bytes = encode_point(scalar_mult(8 * decode_scalar(view_priv), R))
+    x = (x + decode_scalar(keccak256(derivation + encode_varint(out_idx)))) % L
+
+    return encode_point(R), encode_point(scalar_mult(x, G)), x
+
+
+def key_image_signature_valid(signature: bytes, image: bytes, P: bytes, x: int) -> bool:
+    """Checks the (c, r) signature of key image I = x.H_p(P): c = H(I || rG + cP || rH_p(P) + cI)"""
+    c: int = decode_scalar(signature[:32])
+    r: int = decode_scalar(signature[32:])
+    I = decode_point(image)
+    # H_p(P) from the key image, as x is known here
+    Hp = scalar_mult(pow(x, L - 2, L), I)
+    L0 = point_add(scalar_mult(r, G), scalar_mult(c, decode_point(P)))
+    R0 = point_add(scalar_mult(r, Hp), scalar_mult(c, I))
+
+    return decode_scalar(keccak256(image + encode_point(L0) + encode_point(R0))) == c
+
+
+def test_reserve_proof(monero, button):
+    pub_key: bytes = bytes.fromhex("3cad24457b5b505674af0296976ea36baeab28407bc6f4441ee220aa78900296")
+
+    monero.reserve_proof_start(button)
+    assert monero.reserve_proof_finish() == (0, hashlib.sha256(b"").digest())
+
+    # Outputs of the wallet: one to the main address, two to subaddresses (two APDUs)
+    outputs = [(0, 0, 3), (0, 1, 0), (1, 2, 1)]
+    entries = []
+    for seed, (major, minor, out_idx) in enumerate(outputs):
+        R, P, x = owned_output(decode_scalar(keccak256(b"r" + bytes([seed]))), out_idx, major, minor)
+        entries.append((R, out_idx, major, minor, P, x))
+
+    monero.reserve_proof_start(button)
+    signed = monero.reserve_proof_entries([entry[:5] for entry in entries])
+    count, digest = monero.reserve_proof_finish()
+
+    assert count == len(entries)
+    assert digest == hashlib.sha256(b"".join(P + image + signature
+                                             for (_, _, _, _, P, _), (image, signature)
+                                             in zip(entries, signed))).digest()
+    for (_, _, _, _, P, x), (image, signature) in zip(entries, signed):
+        # the same key image as a plain GEN_KEY_IMAGE of the output gives
+        assert image == monero.generate_key_image(
+            _priv_key=monero.xor_cipher(encode_scalar(x), b"\x55"),
+            pub_key=P
+        )
+        assert key_image_signature_valid(signature, image, P, x)
+
+    # An output key that does not match the derived secret key ends the session
+    monero.reserve_proof_start(button)
+    with pytest.raises(WrongData):
+        monero.reserve_proof_entries([(pub_key, 0, 0, 0, pub_key)])
+    with pytest.raises(CommandNotAllowed):
+        monero.reserve_proof_finish()
+    monero.reset_and_get_version(b"10.0.0")
+
+def test_hash_to_ec_cache(monero):
+    # the key image of test_key_image, computed on the host
+    known_image: bytes = bytes.fromhex("b0d5e19411f97c4974217d210f8d50d74731bc062fdb0cf690136ee16d7daa9c")
+    known_key: Tuple[bytes, bytes] = (
+        bytes.fromhex("38306180e44a3ca14f4f18b505bce76330a7b03df8c8611ac9bd4ed70c6ce454"),
+        bytes.fromhex("3cad24457b5b505674af0296976ea36baeab28407bc6f4441ee220aa78900296")
+    )
+    # more keys than the cache holds
+    keys = [known_key] + stake_keys(monero, 5)
+    images = {0: known_image}
+
+    # first seen (misses), again in another order (hits, or misses once evicted), twice in a row
+    for i in list(range(6)) + [5, 3, 0, 1, 4, 2] + [2, 0, 0, 5, 5]:
+        _priv_key, pub_key = keys[i]
+        image: bytes = monero.generate_key_image(_priv_key=_priv_key, pub_key=pub_key)
+        assert images.setdefault(i, image) == image
+        # the signature right after the key image uses the cached H_p(P)
+        signature: bytes = monero.generate_key_image_signature(image=image,
+                                                               _priv_key=_priv_key,
+                                                               pub_key=pub_key)
+        x: int = decode_scalar(monero.xor_cipher(_priv_key, b"\x55"))
+        assert key_image_signature_valid(signature, image, pub_key, x)
+
+def test_sign_messages(monero, button):
+    messages = [(b"challenge 1", 0, 1),
+                (b"challenge 2", 0, 1),
+                (b"challenge 3", 0, 0)]
+    signatures = monero.sign_messages(button, messages)
+    assert len(signatures) == 3
+    for (message, major, minor), signature in zip(messages, signatures):
+        # signed with the spend key of the subaddress
+        assert signature_valid(signature, keccak256(message), subaddress(major, minor)[1])
+    monero.reset_and_get_version(b"10.0.0")
+
+def test_set_policy(monero, button):
+    # unlocks only, 10 OXEN per tx, 0.05 fee, 100 OXEN budget
+    monero.set_policy(button,
+                      tx_types=1 << 2,
+                      max_tx_amount=10_000_000_000,
+                      max_fee=50_000_000,
+                      budget=100_000_000_000)
+
+    with pytest.raises(Deny):
+        monero.set_policy(button,
+                          tx_types=1 << 0,
+                          max_tx_amount=10_000_000_000,
+                          max_fee=50_000_000,
+                          budget=100_000_000_000,
+                          accept=False)
+
+    monero.clear_policy()
+
+
+def currency_str(atomic_oxen: int) -> str:
+    """Atomic OXEN as the device shows them: no trailing 0 in the decimals, but at least one"""
+    whole, frac = divmod(atomic_oxen, 10**9)
+
+    return f"{whole}.{f'{frac:09d}'.rstrip('0') or '0'}"
+
+
+@pytest.mark.parametrize("max_tx_amount,max_fee,budget", [
+    (0, 1, 2**64 - 1),
+    (10**9, 10**10, 10**19),
+    (999_999_999, 1_000_000_001, 123_456_789_000),
+])
+def test_currency_display(monero, button, max_tx_amount, max_fee, budget):
+    # the policy prompt shows the three amounts; it is rejected once they are read
+    button.clear_screen()
+    with pytest.raises(Deny):
+        monero.set_policy(button,
+                          tx_types=1 << 0,
+                          max_tx_amount=max_tx_amount,
+                          max_fee=max_fee,
+                          budget=budget,
+                          accept=False)
+
+    texts = button.screen_texts()
+    if texts is None:
+        pytest.skip("nothing is displayed without speculos")
+    for amount in (max_tx_amount, max_fee, budget):
+        assert currency_str(amount) in texts
+
+
+def wallet_address(prefix: int, view_pub_key: bytes, spend_pub_key: bytes) -> str:
+    """Monero base58 of prefix || spend || view || checksum, computed here"""
+    data: bytes = encode_varint(prefix) + spend_pub_key + view_pub_key
+
+    return base58_encode(data + keccak256(data)[:4])
+
+
+def test_address_encoding(monero):
+    view_pub_key: bytes = bytes.fromhex(OXEN_VIEW_PUB_KEY)
+    spend_pub_key: bytes = bytes.fromhex(OXEN_SPEND_PUB_KEY)
+
+    # a full mainnet address (one byte prefix, 95 chars) and a testnet one (two bytes, 97 chars)
+    assert wallet_address(114, view_pub_key, spend_pub_key) == OXEN_ADDRESS
+    assert len(OXEN_ADDRESS) == 95
+    assert wallet_address(156, view_pub_key, spend_pub_key) == OXEN_TESTNET_ADDRESS
+
+    # every block of the device one, down to the short last one
+    _, _, address = monero.get_public_keys()  # type: bytes, bytes, str
+    assert len(address) == 97
+    assert address == wallet_address(156, view_pub_key, spend_pub_key)
+
+
+def test_public_key_cache(monero):
+    view_pub_key: bytes = bytes.fromhex(OXEN_VIEW_PUB_KEY)
+    spend_pub_key: bytes = bytes.fromhex(OXEN_SPEND_PUB_KEY)
+
+    # Another network: the same keys, but the cached address is built again
+    monero.reset_network(0)  # mainnet
+    for _ in range(2):
+        monero.reset_and_get_version(b"10.0.0")
+        info = monero.hello(b"10.0.0")
+        assert info["nettype"] == 0
+        assert (info["view_pub_key"], info["spend_pub_key"]) == (view_pub_key, spend_pub_key)
+        assert info["address"] == OXEN_ADDRESS
+        assert monero.get_public_keys() == (view_pub_key, spend_pub_key, OXEN_ADDRESS)
+    monero.reset_network(1)  # testnet
+    monero.reset_and_get_version(b"10.0.0")
+    assert monero.get_public_keys() == (view_pub_key, spend_pub_key, OXEN_TESTNET_ADDRESS)
+
+    # Other keys: the cached public keys are computed again
+    a: int = decode_scalar(keccak256(b"put view key"))
+    b: int = decode_scalar(keccak256(b"put spend key"))
+    A: bytes = encode_point(scalar_mult(a, G))
+    B: bytes = encode_point(scalar_mult(b, G))
+    monero.put_key(priv_view_key=encode_scalar(a),
+                   pub_view_key=A,
+                   priv_spend_key=encode_scalar(b),
+                   pub_spend_key=B,
+                   address=wallet_address(156, A, B))
+    monero.reset_and_get_version(b"10.0.0")
+    assert monero.get_public_keys() == (A, B, wallet_address(156, A, B))
+    assert monero.hello(b"10.0.0")["address"] == wallet_address(156, A, B)
+
+    # back to the keys of the seed
+    monero.reset_network(1)
     monero.reset_and_get_version(b"10.0.0")
+    assert monero.get_public_keys() == (view_pub_key, spend_pub_key, OXEN_TESTNET_ADDRESS)
+
+
+def subaddress(major: int, minor: int):
+    """(C, D) of the subaddress, computed here; (0, 0) is the main address"""
+    if major == 0 and minor == 0:
+        return bytes.fromhex(OXEN_VIEW_PUB_KEY), bytes.fromhex(OXEN_SPEND_PUB_KEY)
+    view_priv: bytes = bytes.fromhex(OXEN_VIEW_PRIV_KEY)
+    m = decode_scalar(keccak256(b"SubAddr\x00" + view_priv + struct.pack("<II", major, minor)))
+    D = point_add(decode_point(bytes.fromhex(OXEN_SPEND_PUB_KEY)), scalar_mult(m, G))
+    C = scalar_mult(decode_scalar(view_priv), D)
+
+    return encode_point(C), encode_point(D)
+
+
+def signature_valid(signature: bytes, hash: bytes, pub_key: bytes) -> bool:
+    """Checks a (c, s) signature of hash: c = H(hash || A || s.G + c.A) mod L"""
+    c: int = decode_scalar(signature[:32])
+    s: int = decode_scalar(signature[32:])
+    R = point_add(scalar_mult(s, G), scalar_mult(c, decode_point(pub_key)))
+
+    return decode_scalar(keccak256(hash + pub_key + encode_point(R))) == c
+
+
+def test_subaddress_table(monero, button):
+    monero.disable_subaddress_table()
+
+    with pytest.raises(WrongDataRange):
+        monero.set_subaddress_table(None, majors=0, minors=4)
+    with pytest.raises(Deny):
+        monero.set_subaddress_table(button, majors=2, minors=4, accept=False)
+
+    # 2 accounts of 4 subaddresses: 7 entries (the main address is never stored)
+    monero.set_subaddress_table(button, majors=2, minors=4)
+    # a miss is computed but leaves the table alone: only the build writes it
+    assert monero.get_subaddress(0, 1) == subaddress(0, 1)
+    # four at a time
+    assert monero.build_subaddress_table() == 3
+    assert monero.build_subaddress_table() == 0
+    assert monero.build_subaddress_table() == 0
+    # from the table
+    assert monero.get_subaddress(1, 3) == subaddress(1, 3)
+    assert monero.get_subaddress(0, 2) == subaddress(0, 2)
+    # outside of it
+    assert monero.get_subaddress(2, 0) == subaddress(2, 0)
+
+    monero.disable_subaddress_table()
+    assert monero.get_subaddress(1, 3) == subaddress(1, 3)
@@ -1,7 +1,28 @@
+from typing import List, Optional, Tuple
+
 import pytest
 
 from monero_client.monero_types import SigType, Keys
-from monero_client.exception import ClientNotSupported
+from monero_client.crypto.ed25519 import (L, commit, decode_point, decode_scalar,
+                                          encode_point, encode_scalar, mul_base,
+                                          scalar_mult)
+from monero_client.crypto.keccak import keccak256
+from monero_client.crypto.sha3 import sc_reduce32
+from monero_client.exception import (ClientNotSupported, CommandNotAllowed, Deny,
+                                    SubCommandNotAllowed)
+from monero_client.utils.varint import encode_varint
+
+RECEIVER = Keys(
+    public_view_key=bytes.fromhex("2e49ad29a1bfd98ab05c88713463d55212"
+                                  "0906b1be380211745695134e183ed0"),
+    public_spend_key=bytes.fromhex("392c4432e5a15aea227e6579a8da7d9f4"
+                                   "6fb78565e18e7f0b278f3f1a1468696"),
+    secret_view_key=bytes.fromhex("57fd02a94c7486722b1f9798dc0fb931d5"
+                                  "477a605a6fd6593573b438c02a890f"),
+    secret_spend_key=None,
+    addr="53zomVuwRkDgAQDY6qKUP6TeBy5JqXSJzhG4i7447yMXS7wdt4hKh6gQCTT"
+         "a9FiYNpEjBoHZ9iTww3vL96P1hcmTQXvpFAo"
+)
 
 
 @pytest.mark.incremental
@@ -24,20 +45,8 @@ class TestSignature:
                  "cMdSg7A3b71RejLzB8EkGbfjp5PELVHCRUaE"
         )
 
-        receiver = Keys(
-            public_view_key=bytes.fromhex("2e49ad29a1bfd98ab05c88713463d55212"
-                                          "0906b1be380211745695134e183ed0"),
-            public_spend_key=bytes.fromhex("392c4432e5a15aea227e6579a8da7d9f4"
-                                           "6fb78565e18e7f0b278f3f1a1468696"),
-            secret_view_key=bytes.fromhex("57fd02a94c7486722b1f9798dc0fb931d5"
-                                          "477a605a6fd6593573b438c02a890f"),
-            secret_spend_key=None,
-            addr="53zomVuwRkDgAQDY6qKUP6TeBy5JqXSJzhG4i7447yMXS7wdt4hKh6gQCTT"
-                 "a9FiYNpEjBoHZ9iTww3vL96P1hcmTQXvpFAo"
-        )
-
         return {"sender": sender,
-                "receiver": receiver,
+                "receiver": RECEIVER,
                 "amount": 10**12,  # 1.0 XMR
                 "tx_pub_key": None,
                 "_tx_priv_key": None,
@@ -68,6 +77,16 @@ class TestSignature:
         state["tx_pub_key"] = tx_pub_key
         state["_tx_priv_key"] = _tx_priv_key
 
+    @staticmethod
+    def test_get_additional_keys(monero, state):
+        additional_tx_pub_keys = monero.get_additional_keys(
+            destinations=[(state["receiver"].public_spend_key, False),
+                          (state["receiver"].public_spend_key, True)]
+        )  # type: List[bytes]
+
+        assert len(additional_tx_pub_keys) == 2
+        assert additional_tx_pub_keys[0] != additional_tx_pub_keys[1]
+
     @staticmethod
     def test_gen_txout_keys(monero, state):
         _ak_amount, out_ephemeral_pub_key = monero.gen_txout_keys(
@@ -100,6 +119,28 @@ class TestSignature:
         s: bytes = monero.gen_commitment_mask(state["_ak_amount"][0])
         state["y"].append(s)  # y_t
 
+    @staticmethod
+    def test_blind_batch(monero, state):
+        assert len(state["y"]) != 0
+        assert len(state["_ak_amount"]) != 0
+
+        (mask, blinded_amount), *_ = monero.blind_batch(
+            _ak_amounts=state["_ak_amount"][:1],
+            amounts=[state["amount"]]
+        )  # type: bytes, bytes
+
+        # the batched mask is the one of INS_GEN_COMMITMENT_MASK
+        assert mask == state["y"][0]
+
+        _, amount = monero.unblind(
+            _ak_amount=state["_ak_amount"][0],
+            blinded_mask=b"\x00" * 32,
+            blinded_amount=blinded_amount + b"\x00" * 24,
+            is_short=True
+        )  # type: bytes, bytes
+
+        assert state["amount"] == int.from_bytes(amount[:8], byteorder="little")
+
     @staticmethod
     def test_blind(monero, state):
         assert len(state["y"]) != 0
@@ -157,3 +198,616 @@ class TestSignature:
     @staticmethod
     def test_close_tx(monero):
         monero.close_tx()
+
+
+def start_tx(monero,
+             button,
+             amounts: List[int],
+             fee: int = 100000000,
+             fake: bool = False,
+             tx_keys: Optional[Tuple[bytes, bytes]] = None,
+             fee_prompt: bool = True,
+             change: Optional[Tuple[bytes, bytes]] = None
+             ) -> Tuple[bytes, List[Tuple[bytes, bytes, bytes]]]:
+    """Runs a tx with one output to RECEIVER per amount, up to the VALIDATE init.
+
+    The tx is opened here, unless the R and encrypted r of an open one are given.  Returns the
+    prefix hash, and the encrypted amount key, blinded amount and commitment of each output.  A
+    fake tx (fee estimation) has nothing to confirm, and fee_prompt is False for a fee covered by
+    the signing policy.  With change (view and spend public keys), the last output is flagged as
+    change to that address instead.
+    """
+    if tx_keys is None:
+        tx_keys = monero.open_tx()[:2]
+    tx_pub_key, _tx_priv_key = tx_keys
+
+    _ak_amounts: List[bytes] = []
+    for i in range(len(amounts)):
+        is_change: bool = change is not None and i == len(amounts) - 1
+        A, B = change if is_change else (RECEIVER.public_view_key, RECEIVER.public_spend_key)
+        _ak_amount, _ = monero.gen_txout_keys(
+            _tx_priv_key=_tx_priv_key,
+            tx_pub_key=tx_pub_key,
+            dst_pub_view_key=A,
+            dst_pub_spend_key=B,
+            output_index=i,
+            is_change_addr=is_change,
+            is_subaddress=False
+        )  # type: bytes, bytes
+        _ak_amounts.append(_ak_amount)
+
+    # no timelock: nothing to confirm
+    monero.prefix_hash_init(button=button, version=4, timelock=0)
+    prefix_hash: bytes = monero.prefix_hash_update(payload=b"", is_last=True)
+
+    outputs: List[Tuple[bytes, bytes, bytes]] = [
+        (_ak_amount, blinded_amount, commit(amount, mask))
+        for _ak_amount, amount, (mask, blinded_amount) in zip(
+            _ak_amounts,
+            amounts,
+            monero.blind_batch(_ak_amounts=_ak_amounts, amounts=amounts)
+        )
+    ]
+
+    # should ask for fee validation
+    monero.validate_prehash_init(button=button if fee_prompt and not fake else None,
+                                 index=1,
+                                 txntype=0,
+                                 txnfee=fee)
+
+    return prefix_hash, outputs
+
+
+def validate_output(monero,
+                    index: int,
+                    output: Tuple[bytes, bytes, bytes],
+                    is_last: bool,
+                    wait: bool = True,
+                    change: Optional[Tuple[bytes, bytes]] = None):
+    """Sends an output to RECEIVER, or a change output to the given keys."""
+    _ak_amount, blinded_amount, commitment = output
+    A, B = change if change is not None else (RECEIVER.public_view_key,
+                                              RECEIVER.public_spend_key)
+    monero.validate_prehash_update(
+        index=index,
+        is_short=True,
+        is_change_addr=change is not None,
+        is_subaddress=False,
+        dst_pub_view_key=A,
+        dst_pub_spend_key=B,
+        _ak_amount=_ak_amount,
+        commitment=commitment,
+        blinded_mask=b"\x00" * 32,
+        blinded_amount=blinded_amount + b"\x00" * 24,
+        is_last=is_last,
+        wait=wait
+    )
+
+
+def pre_clsag_hash(prefix_hash: bytes,
+                   fee: int,
+                   outputs: List[Tuple[bytes, bytes, bytes]],
+                   proof: bytes) -> bytes:
+    H: bytes = keccak256(b"".join([b"\x00", encode_varint(fee)] +
+                                  [blinded_amount for _, blinded_amount, _ in outputs] +
+                                  [commitment for _, _, commitment in outputs]))
+
+    return keccak256(prefix_hash + H + proof)
+
+
+def send_tx(monero,
+            button,
+            amounts: List[int],
+            fee: int = 100000000,
+            fake: bool = False,
+            tx_keys: Optional[Tuple[bytes, bytes]] = None,
+            prompt: bool = True,
+            fee_prompt: bool = True,
+            change: Optional[Tuple[bytes, bytes]] = None) -> bytes:
+    """Runs a tx up to its pre-CLSAG hash (see start_tx()).
+
+    Only the last output can have a prompt (a single output, or the summary mode), and prompt
+    tells whether it has one.
+    """
+    prefix_hash, outputs = start_tx(monero, button, amounts, fee, fake, tx_keys, fee_prompt,
+                                    change)
+
+    # the last one shows its prompt, and is answered right away
+    for i, output in enumerate(outputs):
+        is_last: bool = i == len(outputs) - 1
+        validate_output(monero, i + 1, output, is_last=is_last,
+                        change=change if is_last else None)
+
+    proof: bytes = b"\x00" * 32
+    # held until the prompt is accepted
+    pre_hash: bytes = monero.validate_prehash_finalize(
+        button=button if prompt and not fake else None,
+        index=1,
+        commitments=[commitment for _, _, commitment in outputs],
+        message=prefix_hash,
+        proof=proof
+    )
+    assert pre_hash == pre_clsag_hash(prefix_hash, fee, outputs, proof)
+
+    return pre_hash
+
+
+def clsag_slot(seed: int) -> Tuple[int, int, bytes]:
+    """p, z and the hashed key H of a test input."""
+    p: int = decode_scalar(keccak256(b"p" + bytes([seed])))
+    z: int = decode_scalar(keccak256(b"z" + bytes([seed])))
+    H: bytes = mul_base(decode_scalar(keccak256(b"H" + bytes([seed]))))
+
+    return p, z, H
+
+
+def prepare_clsag_batch(monero, count: int) -> List[Tuple[int, int, bytes, bytes, bytes]]:
+    slots = []
+    for seed in range(count):
+        p, z, H = clsag_slot(seed)
+        aG, aH, I, D = monero.clsag_prepare_slot(
+            _p=monero.xor_cipher(encode_scalar(p), b"\x55"),
+            z=encode_scalar(z),
+            H=H
+        )  # type: bytes, bytes, bytes, bytes
+
+        assert I == encode_point(scalar_mult(p, decode_point(H)))
+        assert D == encode_point(scalar_mult(z, decode_point(H)))
+
+        slots.append((p, z, H, aG, aH))
+
+    return slots
+
+
+def sign_clsag_batch(monero, count: int) -> None:
+    """Signs a batch of count inputs and checks the s values."""
+    slots = prepare_clsag_batch(monero, count)
+
+    c: List[int] = []
+    for i in range(len(slots)):
+        data: bytes = b"ring data " + bytes([i]) * 64
+        c_i: bytes = monero.clsag_hash(data)
+        assert c_i == sc_reduce32(keccak256(data))
+        c.append(decode_scalar(c_i))
+
+    mu: List[Tuple[bytes, bytes]] = [(keccak256(b"mu_P" + bytes([i])),
+                                      keccak256(b"mu_C" + bytes([i])))
+                                     for i in range(len(slots))]
+    # one entry per page: [5,1] then [5,0]
+    signatures: List[bytes] = monero.clsag_sign_slots(mu, page_size=1)
+
+    for (p, z, H, aG, aH), c_i, (mu_P, mu_C), s in zip(slots, c, mu, signatures):
+        # s = a - c*(mu_P*p + mu_C*z), so s + c*(mu_P*p + mu_C*z) is the a of a.G and a.H
+        a: int = (decode_scalar(s) +
+                  c_i * (decode_scalar(mu_P) * p + decode_scalar(mu_C) * z)) % L
+        assert mul_base(a) == aG
+        assert encode_point(scalar_mult(a, decode_point(H))) == aH
+
+
+def test_clsag_batch(monero, button):
+    monero.reset_and_get_version(monero_client_version=b"10.0.0")
+    assert monero.set_signature_mode(sig_type=SigType.REAL) == SigType.REAL
+
+    send_tx(monero, button, amounts=[10**9])
+    # 2 slots: the most a Nano S can hold
+    sign_clsag_batch(monero, 2)
+
+    monero.close_tx()
+
+
+@pytest.mark.parametrize("misuse", ["sign_twice", "page_order", "extra_hash"])
+def test_clsag_batch_sequence(monero, button, misuse):
+    monero.reset_and_get_version(monero_client_version=b"10.0.0")
+    assert monero.set_signature_mode(sig_type=SigType.REAL) == SigType.REAL
+
+    send_tx(monero, button, amounts=[10**9])
+
+    slots = prepare_clsag_batch(monero, 2)
+    for i in range(len(slots)):
+        monero.clsag_hash(b"ring data " + bytes([i]))
+
+    mu: Tuple[bytes, bytes] = (keccak256(b"mu_P"), keccak256(b"mu_C"))
+
+    with pytest.raises(SubCommandNotAllowed):
+        if misuse == "sign_twice":
+            monero.clsag_sign_slots([mu, mu])
+            # the batch is done: its slots can't be signed again
+            monero.clsag_sign_page(0, [mu])
+        elif misuse == "page_order":
+            monero.clsag_sign_page(1, [mu])
+            monero.clsag_sign_page(3, [mu])
+        else:
+            # each slot gets exactly one hash
+            monero.clsag_hash(b"ring data")
+
+    # the error aborted the tx
+    monero.reset_and_get_version(monero_client_version=b"10.0.0")
+
+
+def test_clsag_batch_reset(monero, button):
+    monero.reset_and_get_version(monero_client_version=b"10.0.0")
+    assert monero.set_signature_mode(sig_type=SigType.REAL) == SigType.REAL
+    public_keys = monero.get_public_keys()
+
+    send_tx(monero, button, amounts=[10**9])
+    slots = prepare_clsag_batch(monero, 2)
+    for i in range(len(slots)):
+        monero.clsag_hash(b"ring data " + bytes([i]))
+
+    # A RESET keeps the keys but not the slots: nothing is left to sign
+    monero.reset_and_get_version(monero_client_version=b"10.0.0")
+    assert monero.get_public_keys() == public_keys
+    with pytest.raises(CommandNotAllowed):
+        monero.clsag_sign_page(1, [(keccak256(b"mu_P"), keccak256(b"mu_C"))])
+
+    # and the next tx starts from empty slots
+    monero.reset_and_get_version(monero_client_version=b"10.0.0")
+    assert monero.set_signature_mode(sig_type=SigType.REAL) == SigType.REAL
+    send_tx(monero, button, amounts=[10**9])
+    sign_clsag_batch(monero, 2)
+    monero.close_tx()
+
+
+@pytest.mark.parametrize("misuse", ["validate", "single_blind"])
+def test_blind_batch_open(monero, button, misuse):
+    monero.reset_and_get_version(monero_client_version=b"10.0.0")
+    assert monero.set_signature_mode(sig_type=SigType.REAL) == SigType.REAL
+
+    tx_pub_key, _tx_priv_key = monero.open_tx()[:2]
+    _ak_amount, _ = monero.gen_txout_keys(
+        _tx_priv_key=_tx_priv_key,
+        tx_pub_key=tx_pub_key,
+        dst_pub_view_key=RECEIVER.public_view_key,
+        dst_pub_spend_key=RECEIVER.public_spend_key,
+        output_index=0,
+        is_change_addr=False,
+        is_subaddress=False
+    )  # type: bytes, bytes
+    monero.prefix_hash_init(button=button, version=4, timelock=0)
+    monero.prefix_hash_update(payload=b"", is_last=True)
+
+    # the first page of a batch, whose last page ([BLIND,1,0]) never comes
+    monero.blind_batch(_ak_amounts=[_ak_amount], amounts=[10**9], page=1)
+    with pytest.raises(CommandNotAllowed):
+        if misuse == "validate":
+            monero.validate_prehash_init(button=None, index=1, txntype=0, txnfee=100000000)
+        else:
+            monero.blind(_ak_amount=_ak_amount, mask=b"\x00" * 32, amount=10**9, is_short=True)
+
+    # the error aborted the tx
+    monero.reset_and_get_version(monero_client_version=b"10.0.0")
+
+
+def test_fake_then_real(monero, button):
+    # r such that r.G is the pub key below (encrypted), and the key image of that key pair
+    _priv_key: bytes = bytes.fromhex("38306180e44a3ca14f4f18b505bce76330a7b03df8c8611ac9bd4ed70c6ce454")
+    pub_key: bytes = bytes.fromhex("3cad24457b5b505674af0296976ea36baeab28407bc6f4441ee220aa78900296")
+    key_image: bytes = bytes.fromhex("b0d5e19411f97c4974217d210f8d50d74731bc062fdb0cf690136ee16d7daa9c")
+
+    monero.reset_and_get_version(monero_client_version=b"10.0.0")
+    view_pub_key, _, _ = monero.get_public_keys()  # type: bytes, bytes, str
+
+    # Fee estimation: well-formed placeholders instead of curve operations
+    assert monero.set_signature_mode(sig_type=SigType.FAKE) == SigType.FAKE
+
+    (tx_pub_key,
+     _tx_priv_key,
+     _, _) = monero.open_tx()  # type: bytes, bytes, bytes, bytes
+    # R is any valid point
+    assert tx_pub_key == view_pub_key
+
+    # no change derivation to reuse: a payment id encrypted to ourselves derives 8.r.A
+    payment_id: bytes = bytes.fromhex("0123456789abcdef")
+    r: int = decode_scalar(monero.xor_cipher(_tx_priv_key, b"\x55"))
+    mask: bytes = keccak256(encode_point(scalar_mult(8 * r, decode_point(view_pub_key))) +
+                            b"\x8d")
+    assert monero.encrypt_payment_id(pub_key=view_pub_key,
+                                     _priv_key=_tx_priv_key,
+                                     payment_id=payment_id) == bytes(
+        p ^ m for p, m in zip(payment_id, mask))
+
+    assert monero.get_additional_keys(
+        destinations=[(RECEIVER.public_spend_key, False),
+                      (RECEIVER.public_spend_key, True)]
+    ) == [RECEIVER.public_spend_key] * 2
+
+    # the amount key comes back encrypted with a valid hmac
+    _ak_amount, out_ephemeral_pub_key = monero.gen_txout_keys(
+        _tx_priv_key=_tx_priv_key,
+        tx_pub_key=tx_pub_key,
+        dst_pub_view_key=RECEIVER.public_view_key,
+        dst_pub_spend_key=RECEIVER.public_spend_key,
+        output_index=0,
+        is_change_addr=False,
+        is_subaddress=False
+    )  # type: bytes, bytes
+    assert len(_ak_amount) == 32
+    assert out_ephemeral_pub_key == RECEIVER.public_spend_key
+
+    assert monero.generate_key_image(_priv_key=_priv_key, pub_key=pub_key) == pub_key
+
+    monero.close_tx()
+
+    send_tx(monero, button, amounts=[10**9], fake=True)
+    p, z, H = clsag_slot(0)
+    assert monero.clsag_prepare_slot(
+        _p=monero.xor_cipher(encode_scalar(p), b"\x55"),
+        z=encode_scalar(z),
+        H=H
+    ) == (H, H, H, H)
+    assert len(monero.clsag_hash(b"ring data")) == 32
+    s, = monero.clsag_sign_slots([(keccak256(b"mu_P"), keccak256(b"mu_C"))])
+    assert len(s) == 32
+
+    monero.close_tx()
+
+    # The real tx that follows gets real values
+    assert monero.set_signature_mode(sig_type=SigType.REAL) == SigType.REAL
+
+    send_tx(monero, button, amounts=[10**9])
+    sign_clsag_batch(monero, 2)
+    assert monero.generate_key_image(_priv_key=_priv_key, pub_key=pub_key) == key_image
+
+    monero.close_tx()
+
+
+def set_outputs_confirm(button, summary: bool) -> None:
+    """Switches the "Outputs confirm" setting, from the first screen of the main menu."""
+    # "OXEN wallet" -> "Settings" -> select
+    button.right_click()
+    button.both_click()
+    # "<< Main menu" -> ... -> "Outputs confirm" -> select
+    for _ in range(5):
+        button.right_click()
+    button.both_click()
+    # the list starts on the current mode: "Each output" or "Summary"
+    if summary:
+        button.right_click()
+    else:
+        button.left_click()
+    button.both_click()
+    # back on "Outputs confirm" -> ... -> "<< Main menu" -> select
+    for _ in range(5):
+        button.left_click()
+    button.both_click()
+
+
+def test_outputs_summary(monero, button):
+    monero.reset_and_get_version(monero_client_version=b"10.0.0")
+    set_outputs_confirm(button, summary=True)
+    assert monero.set_signature_mode(sig_type=SigType.REAL) == SigType.REAL
+
+    # Nothing to confirm until the last output, which shows the summary
+    send_tx(monero, button, amounts=[10**9, 2 * 10**9, 3 * 10**9])
+    sign_clsag_batch(monero, 1)
+    monero.close_tx()
+
+    set_outputs_confirm(button, summary=False)
+
+
+def test_subtx_session(monero, button):
+    monero.reset_and_get_version(monero_client_version=b"10.0.0")
+    assert monero.set_signature_mode(sig_type=SigType.REAL) == SigType.REAL
+
+    # One approval for the outputs to RECEIVER of all the txes of the session, up to 5 OXEN
+    tx_keys = monero.open_tx(
+        button=button,
+        session=(5 * 10**9, RECEIVER.public_view_key, RECEIVER.public_spend_key)
+    )[:2]
+
+    # within the cap: only the fee is prompted for
+    send_tx(monero, button, amounts=[10**9, 2 * 10**9], tx_keys=tx_keys, prompt=False)
+    sign_clsag_batch(monero, 1)
+
+    # the next tx of the session, once the CLSAGs are done
+    next_tx_keys = monero.open_subtx()[:2]
+    assert next_tx_keys[0] != tx_keys[0]
+    send_tx(monero, button, amounts=[2 * 10**9], tx_keys=next_tx_keys, prompt=False)
+    sign_clsag_batch(monero, 1)
+
+    # the cap is used up: the output gets its prompt again
+    send_tx(monero, button, amounts=[10**9], tx_keys=monero.open_subtx()[:2])
+    sign_clsag_batch(monero, 1)
+
+    # not before every prepared input is signed
+    send_tx(monero, button, amounts=[10**9], tx_keys=monero.open_subtx()[:2])
+    prepare_clsag_batch(monero, 2)
+    for i in range(2):
+        monero.clsag_hash(b"ring data " + bytes([i]))
+    monero.clsag_sign_page(1, [(keccak256(b"mu_P"), keccak256(b"mu_C"))])
+    with pytest.raises(CommandNotAllowed):
+        monero.open_subtx()
+
+    # the error aborted the tx
+    monero.reset_and_get_version(monero_client_version=b"10.0.0")
+
+
+def test_policy_tx(monero, button):
+    monero.reset_and_get_version(monero_client_version=b"10.0.0")
+
+    # standard txes to RECEIVER only, 3 OXEN per tx, 0.2 fee, 4 OXEN budget
+    monero.set_policy(button,
+                      tx_types=1 << 0,
+                      max_tx_amount=3 * 10**9,
+                      max_fee=2 * 10**8,
+                      budget=4 * 10**9)
+    monero.add_policy_dest(button, RECEIVER.public_view_key, RECEIVER.public_spend_key)
+    assert monero.set_signature_mode(sig_type=SigType.REAL) == SigType.REAL
+
+    # covered: neither the fee nor the output get a prompt, and the budget is charged 2 OXEN
+    send_tx(monero, button, amounts=[2 * 10**9], prompt=False, fee_prompt=False)
+    sign_clsag_batch(monero, 1)
+    monero.close_tx()
+
+    # what is left of the budget
+    send_tx(monero, button, amounts=[2 * 10**9], prompt=False, fee_prompt=False)
+    sign_clsag_batch(monero, 1)
+    monero.close_tx()
+
+    # the budget is used up: the output gets its prompt again, the fee is still covered
+    send_tx(monero, button, amounts=[10**9], fee_prompt=False)
+    sign_clsag_batch(monero, 1)
+    monero.close_tx()
+
+    monero.clear_policy()
+
+
+def test_policy_reset(monero, button):
+    monero.reset_and_get_version(monero_client_version=b"10.0.0")
+    public_keys = monero.get_public_keys()
+
+    # 4 OXEN budget: covering a tx also reserves budget / 16 ahead in RAM
+    monero.set_policy(button,
+                      tx_types=1 << 0,
+                      max_tx_amount=3 * 10**9,
+                      max_fee=2 * 10**8,
+                      budget=4 * 10**9)
+    monero.add_policy_dest(button, RECEIVER.public_view_key, RECEIVER.public_spend_key)
+    assert monero.set_signature_mode(sig_type=SigType.REAL) == SigType.REAL
+
+    send_tx(monero, button, amounts=[2 * 10**9], prompt=False, fee_prompt=False)
+    sign_clsag_batch(monero, 1)
+    monero.close_tx()
+
+    # the keys stay warm through a RESET, and so does the reserve: the 2 OXEN left are still
+    # covered, which they wouldn't be with the reserve dropped
+    monero.reset_and_get_version(monero_client_version=b"10.0.0")
+    assert monero.get_public_keys() == public_keys
+    assert monero.set_signature_mode(sig_type=SigType.REAL) == SigType.REAL
+    send_tx(monero, button, amounts=[2 * 10**9], prompt=False, fee_prompt=False)
+    sign_clsag_batch(monero, 1)
+    monero.close_tx()
+
+    monero.clear_policy()
+
+
+def answer_output_prompt(button, accept: bool) -> None:
+    # "Confirm Amount" -> "Reject" (-> "Accept")
+    button.left_click()
+    if accept:
+        button.left_click()
+    button.both_click()
+
+
+def test_policy_change(monero, button):
+    monero.reset_and_get_version(monero_client_version=b"10.0.0")
+    view_pub_key, spend_pub_key, _ = monero.get_public_keys()  # type: bytes, bytes, str
+
+    monero.set_policy(button,
+                      tx_types=1 << 0,
+                      max_tx_amount=3 * 10**9,
+                      max_fee=2 * 10**8,
+                      budget=10 * 10**9)
+    monero.add_policy_dest(button, RECEIVER.public_view_key, RECEIVER.public_spend_key)
+    assert monero.set_signature_mode(sig_type=SigType.REAL) == SigType.REAL
+
+    # change back to the main address is covered
+    send_tx(monero, button, amounts=[10**9, 5 * 10**8], prompt=False, fee_prompt=False,
+            change=(view_pub_key, spend_pub_key))
+    sign_clsag_batch(monero, 1)
+    monero.close_tx()
+
+    # "change" to someone else is shown as an output, and can be rejected
+    foreign: Tuple[bytes, bytes] = (
+        bytes.fromhex("865cbfab852a1d1ccdfc7328e4dac90f78fc2154257d07522e9b79e637326dfa"),
+        bytes.fromhex("dae41d6b13568fdd71ec3d20c2f614c65fe819f36ca5da8d24df3bd89b2bad9d")
+    )
+    prefix_hash, outputs = start_tx(monero, button, amounts=[10**9, 5 * 10**8],
+                                    fee_prompt=False, change=foreign)
+    validate_output(monero, 1, outputs[0], is_last=False)
+    validate_output(monero, 2, outputs[1], is_last=True, change=foreign)
+    answer_output_prompt(button, accept=False)
+    with pytest.raises(Deny):
+        monero.validate_prehash_finalize(button=None,
+                                         index=1,
+                                         commitments=[c for _, _, c in outputs],
+                                         message=prefix_hash,
+                                         proof=b"\x00" * 32)
+    monero.reset_and_get_version(monero_client_version=b"10.0.0")
+
+    monero.clear_policy()
+
+
+def test_prompt_pipeline(monero, button):
+    monero.reset_and_get_version(monero_client_version=b"10.0.0")
+    assert monero.set_signature_mode(sig_type=SigType.REAL) == SigType.REAL
+
+    prefix_hash, outputs = start_tx(monero, button, amounts=[10**9, 2 * 10**9])
+    # SW_OK while the prompt of the first output is still on screen
+    validate_output(monero, 1, outputs[0], is_last=False)
+    # the second one is held until the user answers
+    validate_output(monero, 2, outputs[1], is_last=True, wait=False)
+    assert not monero.reply_pending()
+    answer_output_prompt(button, accept=True)
+    monero.validate_prehash_update_reply()
+
+    # the finalization is held by the prompt of the second output
+    proof: bytes = b"\x00" * 32
+    pre_hash: bytes = monero.validate_prehash_finalize(
+        button=button,
+        index=1,
+        commitments=[commitment for _, _, commitment in outputs],
+        message=prefix_hash,
+        proof=proof
+    )
+    assert pre_hash == pre_clsag_hash(prefix_hash, 100000000, outputs, proof)
+    sign_clsag_batch(monero, 1)
+    monero.close_tx()
+
+
+def test_prompt_pipeline_reject(monero, button):
+    monero.reset_and_get_version(monero_client_version=b"10.0.0")
+    assert monero.set_signature_mode(sig_type=SigType.REAL) == SigType.REAL
+
+    # rejected with a command held: SW_DENY on that command
+    _, outputs = start_tx(monero, button, amounts=[10**9, 2 * 10**9])
+    validate_output(monero, 1, outputs[0], is_last=False)
+    validate_output(monero, 2, outputs[1], is_last=True, wait=False)
+    assert not monero.reply_pending()
+    answer_output_prompt(button, accept=False)
+    with pytest.raises(Deny):
+        monero.validate_prehash_update_reply()
+    monero.reset_and_get_version(monero_client_version=b"10.0.0")
+    assert monero.set_signature_mode(sig_type=SigType.REAL) == SigType.REAL
+
+    # rejected with nothing held: SW_DENY on the next command
+    prefix_hash, outputs = start_tx(monero, button, amounts=[10**9])
+    validate_output(monero, 1, outputs[0], is_last=True)
+    answer_output_prompt(button, accept=False)
+    with pytest.raises(Deny):
+        monero.validate_prehash_finalize(button=None,
+                                         index=1,
+                                         commitments=[outputs[0][2]],
+                                         message=prefix_hash,
+                                         proof=b"\x00" * 32)
+    monero.reset_and_get_version(monero_client_version=b"10.0.0")
+    assert monero.set_signature_mode(sig_type=SigType.REAL) == SigType.REAL
+
+    # RESET still goes through while a prompt is up, and drops the tx
+    _, outputs = start_tx(monero, button, amounts=[10**9])
+    validate_output(monero, 1, outputs[0], is_last=True)
+    monero.reset_and_get_version(monero_client_version=b"10.0.0")
+
+
+@pytest.mark.parametrize("timelock", [1, 10, 10**6, 2**64 - 1])
+def test_timelock_display(monero, button, timelock):
+    monero.reset_and_get_version(monero_client_version=b"10.0.0")
+    assert monero.set_signature_mode(sig_type=SigType.REAL) == SigType.REAL
+
+    tx_pub_key, _tx_priv_key = monero.open_tx()[:2]
+    monero.gen_txout_keys(_tx_priv_key=_tx_priv_key,
+                          tx_pub_key=tx_pub_key,
+                          dst_pub_view_key=RECEIVER.public_view_key,
+                          dst_pub_spend_key=RECEIVER.public_spend_key,
+                          output_index=0,
+                          is_change_addr=False,
+                          is_subaddress=False)
+
+    # shown as a plain decimal number
+    button.clear_screen()
+    monero.prefix_hash_init(button=button, version=4, timelock=timelock)
+    texts = button.screen_texts()
+    if texts is not None:
+        assert str(timelock) in texts
+
+    monero.reset_and_get_version(monero_client_version=b"10.0.0")
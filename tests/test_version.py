@@ -23,3 +23,18 @@ def test_version(monero):
 def test_old_client_version(monero):
     # Not supported anymore
     check_refused_version(monero, b"7.0.0")
+
+def test_hello(monero):
+    version = monero.reset_and_get_version(b"10.0.0")
+    _, spend_pub_key, address = monero.get_public_keys()
+
+    hello = monero.hello(b"10.0.0")
+
+    assert hello["version"] == version
+    assert hello["nettype"] == 1  # testnet
+    assert hello["spend_pub_key"] == spend_pub_key
+    assert hello["address"] == address
+
+def test_hello_old_client_version(monero):
+    with pytest.raises(ClientNotSupported):
+        monero.hello(b"7.0.0")